@@ -0,0 +1,95 @@
+import os
+import re
+import struct
+import sys
+import zlib
+
+# compares cell fields of two output folders (reference and reduced precision run)
+# usage: precision_study.py <reference folder> <folder>
+
+
+VTU_TYPES = {b'Int8': 'b', b'UInt8': 'B', b'Int16': 'h', b'UInt16': 'H', b'Int32': 'i', b'UInt32': 'I',
+             b'Int64': 'q', b'UInt64': 'Q', b'Float32': 'f', b'Float64': 'd'}
+
+
+def read_vtu_array(data, offset, header_format, compressor):
+    header_size = struct.calcsize(header_format)
+    if compressor is None:
+        size = struct.unpack(header_format, data[offset:offset + header_size])[0]
+        return data[offset + header_size:offset + header_size + size]
+
+    # vtkZLibDataCompressor: number of blocks, block size, last block size, compressed sizes, blocks
+    blocks_size, block_size, last_block_size = struct.unpack(header_format[0] + 3 * header_format[1], data[offset:offset + 3 * header_size])
+    offset += 3 * header_size
+    compressed_sizes = struct.unpack(header_format[0] + blocks_size * header_format[1], data[offset:offset + blocks_size * header_size])
+    offset += blocks_size * header_size
+    result = b''
+    for bi, compressed_size in enumerate(compressed_sizes):
+        block = zlib.decompress(data[offset:offset + compressed_size])
+        expected_size = last_block_size if bi == blocks_size - 1 and last_block_size > 0 else block_size
+        if len(block) != expected_size:
+            raise ValueError('wrong size of compressed block')
+        result += block
+        offset += compressed_size
+    return result
+
+
+def read_vtu_fields(path):
+    with open(path, 'rb') as file:
+        raw = file.read()
+    header, appended = raw.split(b'<AppendedData encoding="raw">', 1)
+    data = appended[appended.index(b'_') + 1:]
+
+    file_attributes = dict(re.findall(rb'(\w+)="([^"]*)"', re.search(rb'<VTKFile ([^>]*)>', header).group(1)))
+    byte_order = '<' if file_attributes.get(b'byte_order', b'LittleEndian') == b'LittleEndian' else '>'
+    header_format = byte_order + ('Q' if file_attributes.get(b'header_type', b'UInt32') == b'UInt64' else 'I')
+    compressor = file_attributes.get(b'compressor')
+    if compressor is not None and compressor != b'vtkZLibDataCompressor':
+        raise ValueError('unsupported compressor {} in {}'.format(compressor.decode(), path))
+
+    cell_data = header[header.index(b'<CellData>'):]
+    fields = {}
+    for match in re.finditer(rb'<DataArray ([^>]*)/>', cell_data):
+        attributes = dict(re.findall(rb'(\w+)="([^"]*)"', match.group(1)))
+        value_format = VTU_TYPES[attributes[b'type']]
+        values = read_vtu_array(data, int(attributes[b'offset']), header_format, compressor)
+        count = len(values) // struct.calcsize(value_format)
+        fields[attributes[b'Name'].decode()] = list(struct.unpack('%s%d%s' % (byte_order, count, value_format), values))
+    return fields
+
+
+def read_fields(path):
+    if path.endswith('.vtu'):
+        return read_vtu_fields(path)
+    fields = {}
+    name = None
+    with open(path, 'r') as file:
+        for row in file:
+            data = row.split()
+            if len(data) == 0:
+                continue
+            if data[0] in ('SCALARS', 'VECTORS'):
+                name = data[1]
+                fields[name] = []
+            elif data[0] == 'LOOKUP_TABLE':
+                continue
+            elif data[0] in ('CELL_DATA', 'POINT_DATA'):
+                name = None
+            elif name is not None:
+                fields[name].extend(float(value) for value in data)
+    return fields
+
+
+reference_folder, folder = sys.argv[1], sys.argv[2]
+files = [f for f in os.listdir(reference_folder) if f.endswith(('.vtk', '.vtu')) and f != 'mesh_details.vtk']
+files.sort(key=lambda f: int(f.split('.')[0]))
+
+for f in files:
+    reference = read_fields(reference_folder + os.sep + f)
+    fields = read_fields(folder + os.sep + f)
+    print('[{}]'.format(f))
+    for name, values in reference.items():
+        scale = max(abs(value) for value in values)
+        error = max(abs(a - b) for a, b in zip(values, fields[name]))
+        relative = error / scale if scale > 0 else 0
+        print('{:>16} max abs error = {:.3e}, max error / max value = {:.3e}'.format(name, error, relative))
@@ -0,0 +1,165 @@
+#include "Checkpoint.h"
+#include "Config.h"
+#include "grid/Grid.h"
+#include "grid/BaseCell.h"
+#include "utilities/Parallel.h"
+#include "utilities/Utils.h"
+
+#include <fstream>
+#include <cstdint>
+#include <set>
+#include <stdexcept>
+#include <boost/filesystem.hpp>
+
+using namespace boost::filesystem;
+
+struct CheckpointHeader {
+    char signature[8];
+    std::uint32_t iteration;
+    std::uint32_t gasesSize;
+    std::uint32_t impulsesSize;
+    std::uint32_t cellsSize;
+    std::int32_t maxLevel;
+    double courantNumber;
+    double timestep;
+};
+
+static const char SIGNATURE[8] = {'R', 'G', 'S', 'C', 'H', 'K', '0', '2'};
+
+Checkpoint::Checkpoint(const std::string& folder) : _folder(folder) {}
+
+void Checkpoint::write(unsigned int iteration, Grid* grid) {
+    auto config = Config::getInstance();
+
+    // every checkpoint goes to its own folder, so the last complete one is never overwritten
+    path iterationPath{path(_folder) / Utils::toString(iteration)};
+    if (Parallel::isMaster() == true) {
+        create_directories(iterationPath);
+    }
+    Parallel::barrier();
+
+    std::vector<BaseCell*> cells;
+    for (const auto& cell : grid->getCells()) {
+        if (cell->getType() == BaseCell::Type::NORMAL) {
+            cells.push_back(cell.get());
+        }
+    }
+
+    CheckpointHeader header{};
+    std::copy(SIGNATURE, SIGNATURE + sizeof(SIGNATURE), header.signature);
+    header.iteration = iteration;
+    header.gasesSize = static_cast<std::uint32_t>(config->getGases().size());
+    header.impulsesSize = static_cast<std::uint32_t>(config->getImpulseSphere()->getImpulses().size());
+    header.cellsSize = static_cast<std::uint32_t>(cells.size());
+    header.maxLevel = grid->getMaxLevel();
+    header.courantNumber = config->getCourantNumber();
+    header.timestep = config->getTimestep();
+
+    // header, then ids of all cells, then values of cells in the same order
+    path filePath = iterationPath / (Utils::toString(Parallel::getRank()) + ".bin");
+    std::ofstream fs(filePath.generic_string(), std::ios::out | std::ios::binary);
+    fs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (auto cell : cells) {
+        std::int32_t id = cell->getId();
+        fs.write(reinterpret_cast<const char*>(&id), sizeof(id));
+    }
+    for (auto cell : cells) {
+        for (const auto& values : cell->getValues()) {
+            fs.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(double));
+        }
+    }
+    fs.close();
+
+    // checkpoint becomes the last one only when all processes are done
+    auto isFailed = Parallel::allreduce(fs.fail() ? 1 : 0, Parallel::Operation::MAX);
+    if (isFailed != 0) {
+        throw std::runtime_error("can't write checkpoint to folder: " + iterationPath.generic_string());
+    }
+    if (Parallel::isMaster() == true) {
+        path lastPath{path(_folder) / "last"};
+        path tempPath{path(_folder) / "last.tmp"};
+        std::ofstream ls(tempPath.generic_string(), std::ios::out);
+        ls << iteration << " " << Parallel::getSize() << std::endl;
+        ls.close();
+        rename(tempPath, lastPath);
+
+        // previous checkpoint of this run is not needed anymore, other folders are never touched
+        if (_lastIterationFolder.empty() == false && path(_lastIterationFolder) != iterationPath) {
+            remove_all(path(_lastIterationFolder));
+        }
+    }
+    _lastIterationFolder = iterationPath.generic_string();
+    Parallel::barrier();
+}
+
+unsigned int Checkpoint::read(Grid* grid) const {
+    auto config = Config::getInstance();
+
+    unsigned int iteration = 0;
+    int size = 0;
+    path lastPath{path(_folder) / "last"};
+    std::ifstream ls(lastPath.generic_string(), std::ios::in);
+    if (ls.is_open() == false || (ls >> iteration >> size).fail() == true) {
+        throw std::runtime_error("no checkpoint in folder: " + _folder);
+    }
+    ls.close();
+
+    std::set<int> ids;
+    for (const auto& cell : grid->getCells()) {
+        if (cell->getType() == BaseCell::Type::NORMAL) {
+            ids.insert(cell->getId());
+        }
+    }
+
+    // look through files of all processes of saved run and take values of own cells
+    std::map<int, std::vector<std::vector<double>>> valuesMap;
+    int maxLevel = 0;
+    double timestep = 0.0;
+    path iterationPath{path(_folder) / Utils::toString(iteration)};
+    for (int rank = 0; rank < size; rank++) {
+        path filePath = iterationPath / (Utils::toString(rank) + ".bin");
+        std::ifstream fs(filePath.generic_string(), std::ios::in | std::ios::binary);
+
+        CheckpointHeader header{};
+        fs.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (fs.fail() == true || std::equal(SIGNATURE, SIGNATURE + sizeof(SIGNATURE), header.signature) == false) {
+            throw std::runtime_error("wrong checkpoint file: " + filePath.generic_string());
+        }
+        if (header.gasesSize != config->getGases().size() || header.impulsesSize != config->getImpulseSphere()->getImpulses().size()) {
+            throw std::runtime_error("checkpoint doesn't match gases or impulse sphere: " + filePath.generic_string());
+        }
+        // saved timestep is used only with the same levels and courant number
+        if (header.courantNumber != config->getCourantNumber()) {
+            throw std::runtime_error("checkpoint doesn't match courant number: " + filePath.generic_string());
+        }
+        maxLevel = header.maxLevel;
+        timestep = header.timestep;
+
+        std::vector<std::int32_t> fileIds(header.cellsSize);
+        fs.read(reinterpret_cast<char*>(fileIds.data()), fileIds.size() * sizeof(std::int32_t));
+
+        auto valuesOffset = static_cast<std::streamoff>(sizeof(header) + fileIds.size() * sizeof(std::int32_t));
+        auto cellSize = static_cast<std::streamoff>(header.gasesSize * header.impulsesSize * sizeof(double));
+        for (std::size_t i = 0; i < fileIds.size(); i++) {
+            if (ids.count(fileIds[i]) != 0) {
+                std::vector<std::vector<double>> values(header.gasesSize, std::vector<double>(header.impulsesSize));
+                fs.seekg(valuesOffset + static_cast<std::streamoff>(i) * cellSize);
+                for (auto& gasValues : values) {
+                    fs.read(reinterpret_cast<char*>(gasValues.data()), gasValues.size() * sizeof(double));
+                }
+                valuesMap[fileIds[i]] = std::move(values);
+            }
+        }
+        if (fs.fail() == true) {
+            throw std::runtime_error("can't read checkpoint file: " + filePath.generic_string());
+        }
+    }
+
+    grid->restore(valuesMap);
+    if (grid->getMaxLevel() != maxLevel) {
+        throw std::runtime_error("checkpoint doesn't match max time level: " + iterationPath.generic_string());
+    }
+    config->setTimestep(timestep);
+
+    return iteration;
+}
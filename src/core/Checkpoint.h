@@ -0,0 +1,27 @@
+#ifndef RGS_CHECKPOINT_H
+#define RGS_CHECKPOINT_H
+
+#include <string>
+
+class Grid;
+
+// saves values of all normal cells, each process writes its own file;
+// saved values are found by cell id, so run can be restored on any number of processes
+class Checkpoint {
+private:
+    std::string _folder;
+
+    // folder of previous checkpoint written by this run, only it is removed by next checkpoint
+    std::string _lastIterationFolder;
+
+public:
+    explicit Checkpoint(const std::string& folder);
+
+    void write(unsigned int iteration, Grid* grid);
+
+    unsigned int read(Grid* grid) const;
+
+};
+
+
+#endif //RGS_CHECKPOINT_H
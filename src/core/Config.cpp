@@ -1,6 +1,7 @@
 #include "Config.h"
 
 #include <sstream>
+#include <stdexcept>
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/json_parser.hpp>
 
@@ -64,10 +65,33 @@ void Config::load(const std::string& filename) {
 
     _meshFilename = root.get<std::string>("mesh", "");
     _meshUnits = root.get<double>("mesh_units", 1.0);
+    _meshCacheFolder = root.get<std::string>("mesh_cache_folder", "");
 
     _outputFolder = root.get<std::string>("output_folder", "./");
+    _outputFormat = root.get<std::string>("output_format", "vtk");
+    _outputQueueSize = root.get<unsigned int>("output_queue_size", 2);
+    _outputCompressionLevel = root.get<int>("output_compression_level", 0);
+    if (_outputCompressionLevel < 0 || _outputCompressionLevel > 9) {
+        throw std::runtime_error("output compression level must be from 0 to 9: " + std::to_string(_outputCompressionLevel));
+    }
+    _outputTolerance = root.get<double>("output_tolerance", 0.0);
     _maxIterations = root.get<unsigned int>("max_iterations", 0);
     _outEachIteration = root.get<unsigned int>("out_each_iteration", 1);
+    _progressionEachIteration = root.get<unsigned int>("progression_each_iteration", _outEachIteration);
+    _convergenceEachIteration = root.get<unsigned int>("convergence_each_iteration", 0);
+    _convergenceTolerance = root.get<double>("convergence_tolerance", 0.0);
+    _convergenceChecks = root.get<unsigned int>("convergence_checks", 3);
+    _checkpointEachIteration = root.get<unsigned int>("checkpoint_each_iteration", 0);
+    _checkpointFolder = root.get<std::string>("checkpoint_folder", _outputFolder + "/checkpoint");
+    _restartFolder = root.get<std::string>("restart_folder", "");
+    _balanceEachIteration = root.get<unsigned int>("balance_each_iteration", 0);
+    _balanceThreshold = root.get<double>("balance_threshold", 1.1);
+    _transferScheme = root.get<std::string>("transfer_scheme", "explicit");
+    _transferSweeps = root.get<unsigned int>("transfer_sweeps", 2);
+    _courantNumber = root.get<double>("courant_number", 0.95);
+    _maxTimeLevel = root.get<unsigned int>("max_time_level", 0);
+    _transportPrecision = PrecisionUtils::fromString(root.get<std::string>("transport_precision", "double"));
+    _isUsingSharedMemory = root.get<bool>("use_shared_memory", true);
     _isUsingIntegral = root.get<bool>("use_integral", false);
     _isUsingBetaDecay = root.get<bool>("use_beta_decay", false);
 
@@ -163,13 +187,79 @@ void Config::load(const std::string& filename) {
             _boundaryParameters.emplace_back(group, type, temperature, pressure, flow);
         }
     }
+
+    _probes.clear();
+    auto probesNode = root.get_child_optional("probes");
+    if (probesNode) {
+        auto toPoint = [](const boost::property_tree::ptree& node) {
+            return Vector3d(node.get<double>("x", 0), node.get<double>("y", 0), node.get<double>("z", 0));
+        };
+        for (const boost::property_tree::ptree::value_type& probe : *probesNode) {
+            auto name = probe.second.get<std::string>("name");
+
+            std::vector<int> elementIds;
+            auto elementsNode = probe.second.get_child_optional("elements");
+            if (elementsNode) {
+                for (const boost::property_tree::ptree::value_type& value : *elementsNode) {
+                    elementIds.emplace_back(value.second.get_value<int>());
+                }
+            }
+
+            std::vector<Vector3d> points;
+            auto pointsNode = probe.second.get_child_optional("points");
+            if (pointsNode) {
+                for (const boost::property_tree::ptree::value_type& value : *pointsNode) {
+                    points.emplace_back(toPoint(value.second));
+                }
+            }
+
+            // line is sampled uniformly, ends included
+            auto lineNode = probe.second.get_child_optional("line");
+            if (lineNode) {
+                std::vector<Vector3d> ends;
+                for (const boost::property_tree::ptree::value_type& value : *lineNode) {
+                    ends.emplace_back(toPoint(value.second));
+                }
+                auto samples = probe.second.get<unsigned int>("samples", 2);
+                if (ends.size() != 2 || samples < 2) {
+                    throw std::runtime_error("probe line needs two points and at least two samples: " + name);
+                }
+                for (unsigned int si = 0; si < samples; si++) {
+                    points.emplace_back(ends[0] + (ends[1] - ends[0]) * (1.0 * si / (samples - 1)));
+                }
+            }
+
+            _probes.emplace_back(name, elementIds, points);
+        }
+    }
+    _probeEachIteration = root.get<unsigned int>("probe_each_iteration", 1);
 }
 
 std::ostream& operator<<(std::ostream& os, const Config& config) {
     os << "MeshFilename = "     << config._meshFilename                        << std::endl
+       << "MeshCacheFolder = "  << config._meshCacheFolder                     << std::endl
        << "OutputFolder = "     << config._outputFolder                        << std::endl
+       << "OutputFormat = "     << config._outputFormat                        << std::endl
+       << "OutputQueueSize = "  << config._outputQueueSize                     << std::endl
+       << "OutputCompressionLevel = " << config._outputCompressionLevel        << std::endl
+       << "OutputTolerance = "  << config._outputTolerance                     << std::endl
        << "MaxIteration = "     << config._maxIterations                       << std::endl
        << "OutEachIteration = " << config._outEachIteration                    << std::endl
+       << "ProgressionEachIteration = " << config._progressionEachIteration    << std::endl
+       << "ConvergenceEachIteration = " << config._convergenceEachIteration    << std::endl
+       << "ConvergenceTolerance = " << config._convergenceTolerance            << std::endl
+       << "ConvergenceChecks = " << config._convergenceChecks                  << std::endl
+       << "CheckpointEachIteration = " << config._checkpointEachIteration      << std::endl
+       << "CheckpointFolder = " << config._checkpointFolder                    << std::endl
+       << "RestartFolder = "    << config._restartFolder                       << std::endl
+       << "BalanceEachIteration = " << config._balanceEachIteration            << std::endl
+       << "BalanceThreshold = " << config._balanceThreshold                    << std::endl
+       << "TransferScheme = "   << config._transferScheme                      << std::endl
+       << "TransferSweeps = "   << config._transferSweeps                      << std::endl
+       << "CourantNumber = "    << config._courantNumber                       << std::endl
+       << "MaxTimeLevel = "     << config._maxTimeLevel                        << std::endl
+       << "TransportPrecision = " << PrecisionUtils::toString(config._transportPrecision) << std::endl
+       << "UseSharedMemory = "  << config._isUsingSharedMemory                 << std::endl
        << "UseIntegral = "      << config._isUsingIntegral                     << std::endl
        << "UseBetaDecay = "     << config._isUsingBetaDecay                    << std::endl;
 
@@ -177,6 +267,7 @@ std::ostream& operator<<(std::ostream& os, const Config& config) {
     os << "BetaChains = "       << Utils::toString(config._betaChains)         << std::endl;
     os << "Initial = "          << Utils::toString(config._initialParameters)  << std::endl;
     os << "Boundary = "         << Utils::toString(config._boundaryParameters) << std::endl;
+    os << "Probes = "           << Utils::toString(config._probes)             << std::endl;
 
     os << "Normalizer = "       << *config._normalizer                         << std::endl
        << "ImpulseSphere = "          << *config._impulseSphere;
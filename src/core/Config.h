@@ -3,11 +3,13 @@
 
 #include "utilities/Types.h"
 #include "utilities/Normalizer.h"
+#include "utilities/PrecisionUtils.h"
 #include "parameters/Gas.h"
 #include "parameters/BetaChain.h"
 #include "parameters/InitialParameters.h"
 #include "parameters/BoundaryParameters.h"
 #include "parameters/ImpulseSphere.h"
+#include "parameters/Probe.h"
 
 #include <vector>
 #include <string>
@@ -23,11 +25,36 @@ class Config {
 private:
     std::string _meshFilename;
     double _meshUnits;
+    std::string _meshCacheFolder;
 
     std::string _outputFolder;
+    std::string _outputFormat;
+    unsigned int _outputQueueSize;
+    int _outputCompressionLevel;
+    double _outputTolerance;
 
     unsigned int _maxIterations;
     unsigned int _outEachIteration;
+    unsigned int _progressionEachIteration;
+
+    unsigned int _convergenceEachIteration;
+    double _convergenceTolerance;
+    unsigned int _convergenceChecks;
+
+    unsigned int _checkpointEachIteration;
+    std::string _checkpointFolder;
+    std::string _restartFolder;
+
+    unsigned int _balanceEachIteration;
+    double _balanceThreshold;
+
+    std::string _transferScheme;
+    unsigned int _transferSweeps;
+    double _courantNumber;
+    unsigned int _maxTimeLevel;
+
+    PrecisionUtils::Precision _transportPrecision;
+    bool _isUsingSharedMemory;
 
     bool _isUsingIntegral;
     bool _isUsingBetaDecay;
@@ -38,6 +65,9 @@ private:
     std::vector<InitialParameters> _initialParameters;
     std::vector<BoundaryParameters> _boundaryParameters;
 
+    std::vector<Probe> _probes;
+    unsigned int _probeEachIteration;
+
     std::shared_ptr<Normalizer> _normalizer;
     std::shared_ptr<ImpulseSphere> _impulseSphere;
 
@@ -71,10 +101,30 @@ public:
         return _meshUnits;
     }
 
+    const std::string& getMeshCacheFolder() const {
+        return _meshCacheFolder;
+    }
+
     const std::string& getOutputFolder() const {
         return _outputFolder;
     }
 
+    const std::string& getOutputFormat() const {
+        return _outputFormat;
+    }
+
+    unsigned int getOutputQueueSize() const {
+        return _outputQueueSize;
+    }
+
+    int getOutputCompressionLevel() const {
+        return _outputCompressionLevel;
+    }
+
+    double getOutputTolerance() const {
+        return _outputTolerance;
+    }
+
     unsigned int getMaxIterations() const {
         return _maxIterations;
     }
@@ -83,6 +133,66 @@ public:
         return _outEachIteration;
     }
 
+    unsigned int getProgressionEachIteration() const {
+        return _progressionEachIteration;
+    }
+
+    unsigned int getConvergenceEachIteration() const {
+        return _convergenceEachIteration;
+    }
+
+    double getConvergenceTolerance() const {
+        return _convergenceTolerance;
+    }
+
+    unsigned int getConvergenceChecks() const {
+        return _convergenceChecks;
+    }
+
+    unsigned int getCheckpointEachIteration() const {
+        return _checkpointEachIteration;
+    }
+
+    const std::string& getCheckpointFolder() const {
+        return _checkpointFolder;
+    }
+
+    const std::string& getRestartFolder() const {
+        return _restartFolder;
+    }
+
+    unsigned int getBalanceEachIteration() const {
+        return _balanceEachIteration;
+    }
+
+    double getBalanceThreshold() const {
+        return _balanceThreshold;
+    }
+
+    const std::string& getTransferScheme() const {
+        return _transferScheme;
+    }
+
+    unsigned int getTransferSweeps() const {
+        return _transferSweeps;
+    }
+
+    double getCourantNumber() const {
+        return _courantNumber;
+    }
+
+    unsigned int getMaxTimeLevel() const {
+        return _maxTimeLevel;
+    }
+
+    PrecisionUtils::Precision getTransportPrecision() const {
+        return _transportPrecision;
+    }
+
+    bool isUsingSharedMemory() const {
+        return _isUsingSharedMemory;
+    }
+
     bool isUsingIntegral() const {
         return _isUsingIntegral;
     }
@@ -107,6 +217,14 @@ public:
         return _boundaryParameters;
     }
 
+    const std::vector<Probe>& getProbes() const {
+        return _probes;
+    }
+
+    unsigned int getProbeEachIteration() const {
+        return _probeEachIteration;
+    }
+
     Normalizer* getNormalizer() const {
         return _normalizer.get();
     }
@@ -130,10 +248,35 @@ private:
     void serialize(Archive & ar, const unsigned int version) {
         ar & _meshFilename;
         ar & _meshUnits;
+        ar & _meshCacheFolder;
         ar & _outputFolder;
+        ar & _outputFormat;
+        ar & _outputQueueSize;
+        ar & _outputCompressionLevel;
+        ar & _outputTolerance;
 
         ar & _maxIterations;
         ar & _outEachIteration;
+        ar & _progressionEachIteration;
+
+        ar & _convergenceEachIteration;
+        ar & _convergenceTolerance;
+        ar & _convergenceChecks;
+
+        ar & _checkpointEachIteration;
+        ar & _checkpointFolder;
+        ar & _restartFolder;
+
+        ar & _balanceEachIteration;
+        ar & _balanceThreshold;
+
+        ar & _transferScheme;
+        ar & _transferSweeps;
+        ar & _courantNumber;
+        ar & _maxTimeLevel;
+
+        ar & _transportPrecision;
+        ar & _isUsingSharedMemory;
 
         ar & _isUsingIntegral;
         ar & _isUsingBetaDecay;
@@ -144,6 +287,9 @@ private:
         ar & _initialParameters;
         ar & _boundaryParameters;
 
+        ar & _probes;
+        ar & _probeEachIteration;
+
         ar & _normalizer;
         ar & _impulseSphere;
     }
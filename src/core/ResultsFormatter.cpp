@@ -7,6 +7,14 @@
 
 #include <boost/filesystem.hpp>
 #include <iostream>
+#include <sstream>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+#include <zlib.h>
+#include <stdexcept>
 
 using namespace boost::filesystem;
 
@@ -15,7 +23,27 @@ ResultsFormatter::ResultsFormatter() {
     _main = Utils::getCurrentDateAndTime();
     _scalarParams = {Param::PRESSURE, Param::DENSITY, Param::TEMPERATURE};
     _vectorParams = {Param::FLOW, Param::HEATFLOW};
-    _lastResults = {};
+    _seriesPointsSize = 0;
+    _seriesCellsSize = 0;
+    _seriesTopologySize = 0;
+    _compressionLevel = Config::getInstance()->getOutputCompressionLevel();
+    _tolerance = Config::getInstance()->getOutputTolerance();
+
+    const auto& format = Config::getInstance()->getOutputFormat();
+    if (format == "vtk") {
+        _format = Format::VTK;
+    } else if (format == "vtu") {
+        _format = Format::VTU;
+    } else if (format == "xdmf") {
+        _format = Format::XDMF;
+    } else {
+        throw std::runtime_error("unknown output format: " + format);
+    }
+
+    // quantised values are smaller only when they are compressed
+    if (_tolerance > 0.0 && (_format != Format::VTU || _compressionLevel == 0)) {
+        throw std::runtime_error("output tolerance needs vtu output format with compression level above 0");
+    }
 }
 
 void ResultsFormatter::writeAll(unsigned int iteration, Mesh* mesh, const std::vector<CellResults*>& results) {
@@ -29,171 +57,525 @@ void ResultsFormatter::writeAll(unsigned int iteration, Mesh* mesh, const std::v
         create_directory(mainPath);
     }
 
-    path filePath = mainPath / (Utils::toString(iteration) + ".vtk"); // _types[Type::DATA] /
-    std::ofstream fs(filePath.generic_string(), std::ios::out); //  | std::ios::binary
+    // index results once, then keep elements and their results side by side
+    std::unordered_map<int, CellResults*> resultsMap;
+    resultsMap.reserve(results.size());
+    for (auto cellResults : results) {
+        resultsMap[cellResults->getId()] = cellResults;
+    }
+
+    std::vector<int> elements;
+    std::vector<CellResults*> elementResults;
+    elements.reserve(results.size());
+    elementResults.reserve(results.size());
+    for (int ei = 0; ei < mesh->getElementsSize(); ei++) {
+        auto pos = resultsMap.find(mesh->getElementId(ei));
+        if (pos != resultsMap.end()) {
+            elements.push_back(ei);
+            elementResults.push_back(pos->second);
+        }
+    }
+
+    switch (_format) {
+        case Format::VTK:
+            writeVtk((mainPath / (Utils::toString(iteration) + ".vtk")).generic_string(), mesh, elements, elementResults);
+            break;
+        case Format::VTU:
+            writeVtu((mainPath / (Utils::toString(iteration) + ".vtu")).generic_string(), mesh, elements, elementResults);
+            break;
+        case Format::XDMF:
+            writeXdmf(mainPath.generic_string(), iteration, mesh, elements, elementResults);
+            break;
+    }
+}
+
+void ResultsFormatter::writeVtk(const std::string& filename, Mesh* mesh, const std::vector<int>& elements, const std::vector<CellResults*>& results) const {
+    std::ofstream fs(filename, std::ios::out);
 
     // writing file
-    fs << "# vtk DataFile Version 2.0" << std::endl; // header - version and identifier
-    fs << "SAMPLE FILE" << std::endl; // title (256c max)
-    fs << "ASCII" << std::endl; // data type (ASCII or BINARY)
-    fs << "DATASET UNSTRUCTURED_GRID" << std::endl; // type of form
-    fs << std::endl;
+    fs << "# vtk DataFile Version 2.0" << '\n'; // header - version and identifier
+    fs << "SAMPLE FILE" << '\n'; // title (256c max)
+    fs << "ASCII" << '\n'; // data type (ASCII or BINARY)
+    fs << "DATASET UNSTRUCTURED_GRID" << '\n'; // type of form
+    fs << '\n';
 
     // points
-    fs << "POINTS " << mesh->getNodes().size() << " " << "double" << std::endl;
+    fs << "POINTS " << mesh->getNodesSize() << " " << "double" << '\n';
     double units = Config::getInstance()->getMeshUnits();
-    for (const auto& node : mesh->getNodes()) {
-        auto point = node->getPosition();
+    for (int ni = 0; ni < mesh->getNodesSize(); ni++) {
+        auto point = mesh->getNodePosition(ni);
         double x = point.x() / units;
         double y = point.y() / units;
         double z = point.z() / units;
-        fs << x << " " << y << " " << z << std::endl;
+        fs << x << " " << y << " " << z << '\n';
     }
-    fs << std::endl;
+    fs << '\n';
 
     // cells
-    std::vector<Element*> elements;
-    for (const auto& element : mesh->getElements()) {
-        auto pos = std::find_if(results.begin(), results.end(), [&element](CellResults* res) {
-            return element->getId() == res->getId();
-        });
-        if (pos != results.end()) {
-            elements.push_back(element.get());
-        }
-    }
     auto numberOfAllIndices = 0;
     for (auto element : elements) {
-        numberOfAllIndices += element->getNodeIds().size();
+        numberOfAllIndices += mesh->getElementNodes(element).size();
         numberOfAllIndices += 1;
     }
-    fs << "CELLS " << elements.size() << " " << numberOfAllIndices << std::endl;
+    fs << "CELLS " << elements.size() << " " << numberOfAllIndices << '\n';
     for (auto element : elements) {
-        const auto& nodeIds = element->getNodeIds();
-        fs << nodeIds.size();
-        for (const auto& nodeId : nodeIds) {
-            fs << " " << (nodeId - 1);
+        auto nodes = mesh->getElementNodes(element);
+        fs << nodes.size();
+        for (auto node : nodes) {
+            fs << " " << node;
         }
-        fs << std::endl;
+        fs << '\n';
     }
-    fs << std::endl;
+    fs << '\n';
 
     // cell types
-    fs << "CELL_TYPES " << elements.size() << std::endl;
+    fs << "CELL_TYPES " << elements.size() << '\n';
     for (auto element : elements) {
-        int cellType = 0;
-        switch (element->getType()) {
-            case Element::Type::POINT:
-                cellType = 1;
-                break;
-            case Element::Type::LINE:
-                cellType = 3;
-                break;
-            case Element::Type::TRIANGLE:
-                cellType = 5;
-                break;
-            case Element::Type::QUADRANGLE:
-                cellType = 9;
-                break;
-            case Element::Type::TETRAHEDRON:
-                cellType = 10;
-                break;
-            case Element::Type::HEXAHEDRON:
-                cellType = 12;
-                break;
-            case Element::Type::PRISM:
-                cellType = 13;
-                break;
-        }
-        fs << cellType << std::endl;
+        fs << getCellType(mesh->getElementType(element)) << '\n';
     }
-    fs << std::endl;
+    fs << '\n';
 
     // scalar field (density, temperature, pressure) - lookup table "default"
-    fs << "CELL_DATA " << elements.size() << std::endl;
+    fs << "CELL_DATA " << elements.size() << '\n';
 
     auto config = Config::getInstance();
-    auto normalizer = config->getNormalizer();
-
     for (auto gi = 0; gi < config->getGases().size(); gi++) {
         for (auto param : _scalarParams) {
-            std::string paramName;
-            switch (param) {
-                case Param::PRESSURE:
-                    paramName = "Pressure";
-                    break;
-                case Param::DENSITY:
-                    paramName = "Density";
-                    break;
-                case Param::TEMPERATURE:
-                    paramName = "Temperature";
-                    break;
+            fs << "SCALARS " << getParamName(param, gi) << " " << "double" << " " << 1 << '\n';
+            fs << "LOOKUP_TABLE " << "default" << '\n';
+            for (auto cellResults : results) {
+                fs << getScalar(param, cellResults, gi) << '\n';
             }
-            paramName += "_" + Utils::toString(gi);
-
-            fs << "SCALARS " << paramName << " " << "double" << " " << 1 << std::endl;
-            fs << "LOOKUP_TABLE " << "default" << std::endl;
-            for (auto element : elements) {
-                double value = 0.0;
-                auto pos = std::find_if(results.begin(), results.end(), [&element](CellResults* res) {
-                    return element->getId() == res->getId();
-                });
-                if (pos != results.end()) {
-                    switch (param) {
-                        case Param::PRESSURE:
-                            value = normalizer->restore((*pos)->getPressure(gi), Normalizer::Type::PRESSURE);
-                            break;
-                        case Param::DENSITY:
-                            value = normalizer->restore((*pos)->getDensity(gi), Normalizer::Type::DENSITY);
-                            break;
-                        case Param::TEMPERATURE:
-                            value = normalizer->restore((*pos)->getTemp(gi), Normalizer::Type::TEMPERATURE);
-                            break;
-                    }
-                }
-                fs << value << std::endl;
+        }
+
+        for (auto param : _vectorParams) {
+            fs << "VECTORS " << getParamName(param, gi) << " " << "double" << '\n';
+            for (auto cellResults : results) {
+                Vector3d value = getVector(param, cellResults, gi);
+                fs << value.x() << " " << value.y() << " " << value.z() << '\n';
             }
         }
+    }
+
+    fs.close();
+}
+
+void ResultsFormatter::writeVtu(const std::string& filename, Mesh* mesh, const std::vector<int>& elements, const std::vector<CellResults*>& results) const {
+    auto config = Config::getInstance();
 
+    // every data array is one raw block in appended section, prefixed by its size in bytes;
+    // sizes are known beforehand, so the header is written first and blocks are streamed after it
+    struct DataArray {
+        std::string attributes;
+        std::size_t size;
+        std::function<void(std::ostream&)> write;
+    };
+    auto writeBlock = [](std::ostream& fs, const void* data, std::size_t size) {
+        fs.write(static_cast<const char*>(data), size);
+    };
+
+    // points
+    std::vector<DataArray> points;
+    points.push_back({"type=\"Float64\" NumberOfComponents=\"3\"", mesh->getNodesSize() * 3 * sizeof(double), [&](std::ostream& fs) {
+        double units = config->getMeshUnits();
+        for (int ni = 0; ni < mesh->getNodesSize(); ni++) {
+            auto point = mesh->getNodePosition(ni);
+            double values[3] = {point.x() / units, point.y() / units, point.z() / units};
+            writeBlock(fs, values, sizeof(values));
+        }
+    }});
+
+    // cells
+    std::size_t connectivitySize = 0;
+    for (auto element : elements) {
+        connectivitySize += mesh->getElementNodes(element).size();
+    }
+    std::vector<DataArray> cells;
+    cells.push_back({"type=\"Int64\" Name=\"connectivity\"", connectivitySize * sizeof(std::int64_t), [&](std::ostream& fs) {
+        for (auto element : elements) {
+            for (auto node : mesh->getElementNodes(element)) {
+                std::int64_t value = node;
+                writeBlock(fs, &value, sizeof(value));
+            }
+        }
+    }});
+    cells.push_back({"type=\"Int64\" Name=\"offsets\"", elements.size() * sizeof(std::int64_t), [&](std::ostream& fs) {
+        std::int64_t offset = 0;
+        for (auto element : elements) {
+            offset += mesh->getElementNodes(element).size();
+            writeBlock(fs, &offset, sizeof(offset));
+        }
+    }});
+    cells.push_back({"type=\"UInt8\" Name=\"types\"", elements.size(), [&](std::ostream& fs) {
+        for (auto element : elements) {
+            auto type = static_cast<std::uint8_t>(getCellType(mesh->getElementType(element)));
+            writeBlock(fs, &type, sizeof(type));
+        }
+    }});
+
+    // cell fields
+    std::vector<DataArray> fields;
+    for (unsigned int gi = 0; gi < config->getGases().size(); gi++) {
+        for (auto param : _scalarParams) {
+            fields.push_back({"type=\"Float64\" Name=\"" + getParamName(param, gi) + "\"", results.size() * sizeof(double), [&, param, gi](std::ostream& fs) {
+                auto values = getField(param, results, gi);
+                writeBlock(fs, values.data(), values.size() * sizeof(double));
+            }});
+        }
         for (auto param : _vectorParams) {
-            std::string paramName;
-            switch (param) {
-                case Param::FLOW:
-                    paramName = "Flow";
-                    break;
-                case Param::HEATFLOW:
-                    paramName = "HeatFlow";
-                    break;
+            fields.push_back({"type=\"Float64\" Name=\"" + getParamName(param, gi) + "\" NumberOfComponents=\"3\"", results.size() * 3 * sizeof(double), [&, param, gi](std::ostream& fs) {
+                auto values = getField(param, results, gi);
+                writeBlock(fs, values.data(), values.size() * sizeof(double));
+            }});
+        }
+    }
+
+    // compressed arrays are prepared beforehand, their sizes are needed for header
+    std::vector<std::string> compressedArrays;
+    if (_compressionLevel > 0) {
+        for (const auto* arrays : {&points, &cells, &fields}) {
+            for (const auto& array : *arrays) {
+                std::ostringstream os;
+                array.write(os);
+                compressedArrays.push_back(compress(os.str(), _compressionLevel));
+            }
+        }
+    }
+
+    std::ofstream fs(filename, std::ios::out | std::ios::binary);
+    fs << "<?xml version=\"1.0\"?>\n";
+    fs << "<VTKFile type=\"UnstructuredGrid\" version=\"1.0\" byte_order=\"" << (isLittleEndian() ? "LittleEndian" : "BigEndian") << "\" header_type=\"UInt64\"";
+    if (_compressionLevel > 0) {
+        fs << " compressor=\"vtkZLibDataCompressor\"";
+    }
+    fs << ">\n";
+    fs << "  <UnstructuredGrid>\n";
+    fs << "    <Piece NumberOfPoints=\"" << mesh->getNodesSize() << "\" NumberOfCells=\"" << elements.size() << "\">\n";
+
+    std::size_t offset = 0, index = 0;
+    auto writeHeader = [&](const std::string& tag, const std::vector<DataArray>& arrays) {
+        fs << "      <" << tag << ">\n";
+        for (const auto& array : arrays) {
+            fs << "        <DataArray " << array.attributes << " format=\"appended\" offset=\"" << offset << "\"/>\n";
+            if (_compressionLevel > 0) {
+                offset += compressedArrays[index++].size();
+            } else {
+                offset += sizeof(std::uint64_t) + array.size;
+            }
+        }
+        fs << "      </" << tag << ">\n";
+    };
+    writeHeader("Points", points);
+    writeHeader("Cells", cells);
+    writeHeader("CellData", fields);
+
+    fs << "    </Piece>\n";
+    fs << "  </UnstructuredGrid>\n";
+    fs << "  <AppendedData encoding=\"raw\">\n";
+    fs << "_";
+    if (_compressionLevel > 0) {
+        for (const auto& compressedArray : compressedArrays) {
+            writeBlock(fs, compressedArray.data(), compressedArray.size());
+        }
+    } else {
+        for (const auto* arrays : {&points, &cells, &fields}) {
+            for (const auto& array : *arrays) {
+                auto size = static_cast<std::uint64_t>(array.size);
+                writeBlock(fs, &size, sizeof(size));
+                array.write(fs);
+            }
+        }
+    }
+    fs << "\n  </AppendedData>\n";
+    fs << "</VTKFile>\n";
+
+    fs.close();
+}
+
+void ResultsFormatter::writeXdmf(const std::string& folder, unsigned int iteration, Mesh* mesh, const std::vector<int>& elements, const std::vector<CellResults*>& results) {
+    auto config = Config::getInstance();
+    std::string endian = isLittleEndian() ? "Little" : "Big";
+
+    // geometry does not change, so points and mixed topology are written once
+    if (_seriesIterations.empty() == true) {
+        std::ofstream fs(folder + "/geometry.bin", std::ios::out | std::ios::binary);
+
+        double units = config->getMeshUnits();
+        for (int ni = 0; ni < mesh->getNodesSize(); ni++) {
+            auto point = mesh->getNodePosition(ni);
+            double values[3] = {point.x() / units, point.y() / units, point.z() / units};
+            fs.write(reinterpret_cast<const char*>(values), sizeof(values));
+        }
+
+        // each cell is its type, then number of nodes (for points and lines only), then nodes
+        std::vector<std::int64_t> topology;
+        for (auto element : elements) {
+            auto type = mesh->getElementType(element);
+            topology.push_back(getXdmfCellType(type));
+            if (type == Element::Type::POINT || type == Element::Type::LINE) {
+                topology.push_back(static_cast<std::int64_t>(mesh->getElementNodes(element).size()));
             }
-            paramName += "_" + Utils::toString(gi);
-
-            fs << "VECTORS " << paramName << " " << "double" << std::endl;
-            for (auto element : elements) {
-                Vector3d value;
-                auto pos = std::find_if(results.begin(), results.end(), [&element](CellResults* res) {
-                    return element->getId() == res->getId();
-                });
-                if (pos != results.end()) {
-                    switch (param) {
-                        case Param::FLOW:
-                            value = (*pos)->getFlow(gi);
-                            normalizer->restore(value.x(), Normalizer::Type::FLOW);
-                            normalizer->restore(value.y(), Normalizer::Type::FLOW);
-                            normalizer->restore(value.z(), Normalizer::Type::FLOW);
-                            break;
-                        case Param::HEATFLOW:
-                            value = (*pos)->getHeatFlow(gi);
-                            normalizer->restore(value.x(), Normalizer::Type::HEATFLOW);
-                            normalizer->restore(value.y(), Normalizer::Type::HEATFLOW);
-                            normalizer->restore(value.z(), Normalizer::Type::HEATFLOW);
-                            break;
-                    }
-                }
-                fs << value.x() << " " << value.y() << " " << value.z() << std::endl;
+            for (auto node : mesh->getElementNodes(element)) {
+                topology.push_back(node);
             }
         }
+        fs.write(reinterpret_cast<const char*>(topology.data()), topology.size() * sizeof(std::int64_t));
+        fs.close();
+
+        _seriesPointsSize = mesh->getNodesSize();
+        _seriesCellsSize = elements.size();
+        _seriesTopologySize = topology.size();
     }
 
+    // fields of iteration go one after another into one file
+    std::ofstream fs(folder + "/" + Utils::toString(iteration) + ".bin", std::ios::out | std::ios::binary);
+    for (unsigned int gi = 0; gi < config->getGases().size(); gi++) {
+        for (auto param : _scalarParams) {
+            auto values = getField(param, results, gi);
+            fs.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(double));
+        }
+        for (auto param : _vectorParams) {
+            auto values = getField(param, results, gi);
+            fs.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(double));
+        }
+    }
     fs.close();
+    _seriesIterations.push_back(iteration);
+
+    // index is rewritten with every snapshot, so it stays valid while solver runs
+    std::ofstream xs(folder + "/series.xmf", std::ios::out);
+    xs << "<?xml version=\"1.0\" ?>\n";
+    xs << "<Xdmf Version=\"2.0\">\n";
+    xs << "  <Domain>\n";
+    xs << "    <Grid Name=\"Series\" GridType=\"Collection\" CollectionType=\"Temporal\">\n";
+    for (auto seriesIteration : _seriesIterations) {
+        std::string fieldsFilename = Utils::toString(seriesIteration) + ".bin";
+        xs << "      <Grid Name=\"" << seriesIteration << "\" GridType=\"Uniform\">\n";
+        xs << "        <Time Value=\"" << seriesIteration << "\"/>\n";
+        xs << "        <Topology TopologyType=\"Mixed\" NumberOfElements=\"" << _seriesCellsSize << "\">\n";
+        xs << "          <DataItem Format=\"Binary\" DataType=\"Int\" Precision=\"8\" Endian=\"" << endian << "\" Dimensions=\"" << _seriesTopologySize
+           << "\" Seek=\"" << _seriesPointsSize * 3 * sizeof(double) << "\">geometry.bin</DataItem>\n";
+        xs << "        </Topology>\n";
+        xs << "        <Geometry GeometryType=\"XYZ\">\n";
+        xs << "          <DataItem Format=\"Binary\" DataType=\"Float\" Precision=\"8\" Endian=\"" << endian << "\" Dimensions=\"" << _seriesPointsSize << " 3\">geometry.bin</DataItem>\n";
+        xs << "        </Geometry>\n";
+
+        std::size_t seek = 0;
+        auto writeAttribute = [&](Param param, unsigned int gi, unsigned int components) {
+            xs << "        <Attribute Name=\"" << getParamName(param, gi) << "\" AttributeType=\"" << (components == 1 ? "Scalar" : "Vector") << "\" Center=\"Cell\">\n";
+            xs << "          <DataItem Format=\"Binary\" DataType=\"Float\" Precision=\"8\" Endian=\"" << endian << "\" Dimensions=\"" << _seriesCellsSize;
+            if (components != 1) {
+                xs << " " << components;
+            }
+            xs << "\" Seek=\"" << seek << "\">" << fieldsFilename << "</DataItem>\n";
+            xs << "        </Attribute>\n";
+            seek += _seriesCellsSize * components * sizeof(double);
+        };
+        for (unsigned int gi = 0; gi < config->getGases().size(); gi++) {
+            for (auto param : _scalarParams) {
+                writeAttribute(param, gi, 1);
+            }
+            for (auto param : _vectorParams) {
+                writeAttribute(param, gi, 3);
+            }
+        }
+        xs << "      </Grid>\n";
+    }
+    xs << "    </Grid>\n";
+    xs << "  </Domain>\n";
+    xs << "</Xdmf>\n";
+    xs.close();
+}
+
+std::string ResultsFormatter::getParamName(Param param, unsigned int gi) const {
+    std::string paramName;
+    switch (param) {
+        case Param::PRESSURE:
+            paramName = "Pressure";
+            break;
+        case Param::DENSITY:
+            paramName = "Density";
+            break;
+        case Param::TEMPERATURE:
+            paramName = "Temperature";
+            break;
+        case Param::FLOW:
+            paramName = "Flow";
+            break;
+        case Param::HEATFLOW:
+            paramName = "HeatFlow";
+            break;
+    }
+    return paramName + "_" + Utils::toString(gi);
+}
+
+double ResultsFormatter::getScalar(Param param, const CellResults* results, unsigned int gi) const {
+    auto normalizer = Config::getInstance()->getNormalizer();
+
+    double value = 0.0;
+    if (results != nullptr) {
+        switch (param) {
+            case Param::PRESSURE:
+                value = normalizer->restore(results->getPressure(gi), Normalizer::Type::PRESSURE);
+                break;
+            case Param::DENSITY:
+                value = normalizer->restore(results->getDensity(gi), Normalizer::Type::DENSITY);
+                break;
+            case Param::TEMPERATURE:
+                value = normalizer->restore(results->getTemp(gi), Normalizer::Type::TEMPERATURE);
+                break;
+            default:
+                break;
+        }
+    }
+    return value;
+}
+
+Vector3d ResultsFormatter::getVector(Param param, const CellResults* results, unsigned int gi) const {
+    auto normalizer = Config::getInstance()->getNormalizer();
+
+    Vector3d value;
+    if (results != nullptr) {
+        switch (param) {
+            case Param::FLOW:
+                value = results->getFlow(gi);
+                normalizer->restore(value.x(), Normalizer::Type::FLOW);
+                normalizer->restore(value.y(), Normalizer::Type::FLOW);
+                normalizer->restore(value.z(), Normalizer::Type::FLOW);
+                break;
+            case Param::HEATFLOW:
+                value = results->getHeatFlow(gi);
+                normalizer->restore(value.x(), Normalizer::Type::HEATFLOW);
+                normalizer->restore(value.y(), Normalizer::Type::HEATFLOW);
+                normalizer->restore(value.z(), Normalizer::Type::HEATFLOW);
+                break;
+            default:
+                break;
+        }
+    }
+    return value;
+}
+
+std::vector<double> ResultsFormatter::getField(Param param, const std::vector<CellResults*>& results, unsigned int gi) const {
+    std::vector<double> values;
+    if (param == Param::FLOW || param == Param::HEATFLOW) {
+        values.reserve(results.size() * 3);
+        for (auto cellResults : results) {
+            Vector3d value = getVector(param, cellResults, gi);
+            values.push_back(value.x());
+            values.push_back(value.y());
+            values.push_back(value.z());
+        }
+    } else {
+        values.reserve(results.size());
+        for (auto cellResults : results) {
+            values.push_back(getScalar(param, cellResults, gi));
+        }
+    }
+
+    // lossy quantisation: error of each value is within tolerance of field maximum
+    if (_tolerance > 0.0) {
+        double maxValue = 0.0;
+        for (auto value : values) {
+            maxValue = std::max(maxValue, std::abs(value));
+        }
+        double step = 2.0 * _tolerance * maxValue;
+        if (step > 0.0) {
+            for (auto& value : values) {
+                value = std::round(value / step) * step;
+            }
+        }
+    }
+    return values;
+}
+
+std::string ResultsFormatter::compress(const std::string& data, int level) {
+
+    // vtkZLibDataCompressor layout: number of blocks, block size, last block size,
+    // compressed size of each block, then compressed blocks
+    const std::size_t blockSize = 1 << 16;
+    std::size_t blocksSize = (data.size() + blockSize - 1) / blockSize;
+
+    std::vector<std::uint64_t> header(3 + blocksSize);
+    header[0] = blocksSize;
+    header[1] = blockSize;
+    header[2] = data.size() % blockSize;
+
+    std::string blocks;
+    std::vector<Bytef> buffer(compressBound(blockSize));
+    for (std::size_t bi = 0; bi < blocksSize; bi++) {
+        auto size = std::min(blockSize, data.size() - bi * blockSize);
+        auto compressedSize = static_cast<uLongf>(buffer.size());
+        if (compress2(buffer.data(), &compressedSize, reinterpret_cast<const Bytef*>(data.data() + bi * blockSize), size, level) != Z_OK) {
+            throw std::runtime_error("can't compress output data");
+        }
+        header[3 + bi] = compressedSize;
+        blocks.append(reinterpret_cast<const char*>(buffer.data()), compressedSize);
+    }
+
+    std::string result(reinterpret_cast<const char*>(header.data()), header.size() * sizeof(std::uint64_t));
+    return result + blocks;
+}
+
+int ResultsFormatter::getCellType(Element::Type type) {
+    int cellType = 0;
+    switch (type) {
+        case Element::Type::POINT:
+            cellType = 1;
+            break;
+        case Element::Type::LINE:
+            cellType = 3;
+            break;
+        case Element::Type::TRIANGLE:
+            cellType = 5;
+            break;
+        case Element::Type::QUADRANGLE:
+            cellType = 9;
+            break;
+        case Element::Type::TETRAHEDRON:
+            cellType = 10;
+            break;
+        case Element::Type::HEXAHEDRON:
+            cellType = 12;
+            break;
+        case Element::Type::PRISM:
+            cellType = 13;
+            break;
+    }
+    return cellType;
+}
+
+int ResultsFormatter::getXdmfCellType(Element::Type type) {
+    int cellType = 0;
+    switch (type) {
+        case Element::Type::POINT:
+            cellType = 1;
+            break;
+        case Element::Type::LINE:
+            cellType = 2;
+            break;
+        case Element::Type::TRIANGLE:
+            cellType = 4;
+            break;
+        case Element::Type::QUADRANGLE:
+            cellType = 5;
+            break;
+        case Element::Type::TETRAHEDRON:
+            cellType = 6;
+            break;
+        case Element::Type::HEXAHEDRON:
+            cellType = 9;
+            break;
+        case Element::Type::PRISM:
+            cellType = 8;
+            break;
+    }
+    return cellType;
+}
+
+bool ResultsFormatter::isLittleEndian() {
+    std::uint16_t endianness = 1;
+    return *reinterpret_cast<std::uint8_t*>(&endianness) == 1;
 }
 
 void ResultsFormatter::writeMeshDetails(Mesh* mesh) {
@@ -218,10 +600,10 @@ void ResultsFormatter::writeMeshDetails(Mesh* mesh) {
     fs << std::endl;
 
     // points
-    fs << "POINTS " << mesh->getNodes().size() << " " << "double" << std::endl;
+    fs << "POINTS " << mesh->getNodesSize() << " " << "double" << std::endl;
     double units = Config::getInstance()->getMeshUnits();
-    for (const auto& node : mesh->getNodes()) {
-        auto point = node->getPosition();
+    for (int ni = 0; ni < mesh->getNodesSize(); ni++) {
+        auto point = mesh->getNodePosition(ni);
         double x = point.x() / units;
         double y = point.y() / units;
         double z = point.z() / units;
@@ -230,23 +612,23 @@ void ResultsFormatter::writeMeshDetails(Mesh* mesh) {
     fs << std::endl;
 
     // cells
-    std::vector<Element*> elements;
-    for (const auto& element : mesh->getElements()) {
-        if (element->isMain()) {
-            elements.push_back(element.get());
+    std::vector<int> elements;
+    for (int ei = 0; ei < mesh->getElementsSize(); ei++) {
+        if (mesh->isMain(ei)) {
+            elements.push_back(ei);
         }
     }
     auto numberOfAllIndices = 0;
     for (auto element : elements) {
-        numberOfAllIndices += element->getNodeIds().size();
+        numberOfAllIndices += mesh->getElementNodes(element).size();
         numberOfAllIndices += 1;
     }
     fs << "CELLS " << elements.size() << " " << numberOfAllIndices << std::endl;
     for (auto element : elements) {
-        const auto& nodeIds = element->getNodeIds();
-        fs << nodeIds.size();
-        for (const auto& nodeId : nodeIds) {
-            fs << " " << (nodeId - 1);
+        auto nodes = mesh->getElementNodes(element);
+        fs << nodes.size();
+        for (auto node : nodes) {
+            fs << " " << node;
         }
         fs << std::endl;
     }
@@ -255,31 +637,7 @@ void ResultsFormatter::writeMeshDetails(Mesh* mesh) {
     // cell types
     fs << "CELL_TYPES " << elements.size() << std::endl;
     for (auto element : elements) {
-        int cellType = 0;
-        switch (element->getType()) {
-            case Element::Type::POINT:
-                cellType = 1;
-                break;
-            case Element::Type::LINE:
-                cellType = 3;
-                break;
-            case Element::Type::TRIANGLE:
-                cellType = 5;
-                break;
-            case Element::Type::QUADRANGLE:
-                cellType = 9;
-                break;
-            case Element::Type::TETRAHEDRON:
-                cellType = 10;
-                break;
-            case Element::Type::HEXAHEDRON:
-                cellType = 12;
-                break;
-            case Element::Type::PRISM:
-                cellType = 13;
-                break;
-        }
-        fs << cellType << std::endl;
+        fs << getCellType(mesh->getElementType(element)) << std::endl;
     }
     fs << std::endl;
 
@@ -289,10 +647,9 @@ void ResultsFormatter::writeMeshDetails(Mesh* mesh) {
     fs << "LOOKUP_TABLE " << "default" << std::endl;
     for (auto element : elements) {
         double value = 0.0;
-        for (const auto& sideElement : element->getSideElements()) {
-            auto neighborId = sideElement->getNeighborId();
-            auto neighborElement = mesh->getElement(neighborId);
-            if (neighborElement->isBorder()) {
+        for (int si = mesh->getSidesBegin(element); si < mesh->getSidesEnd(element); si++) {
+            auto neighbor = mesh->getElementIndex(mesh->getSideNeighborId(si));
+            if (mesh->isBorder(neighbor)) {
                 value += 1.0;
             }
         }
@@ -303,12 +660,11 @@ void ResultsFormatter::writeMeshDetails(Mesh* mesh) {
     for (auto element : elements) {
         bool hasBorderSide = false;
         Vector3d value;
-        for (const auto& sideElement : element->getSideElements()) {
-            auto neighborId = sideElement->getNeighborId();
-            auto neighborElement = mesh->getElement(neighborId);
-            if (neighborElement->isBorder()) {
+        for (int si = mesh->getSidesBegin(element); si < mesh->getSidesEnd(element); si++) {
+            auto neighbor = mesh->getElementIndex(mesh->getSideNeighborId(si));
+            if (mesh->isBorder(neighbor)) {
                 hasBorderSide = true;
-                value += sideElement->getNormal();
+                value += mesh->getSideNormal(si);
             }
         }
         if (hasBorderSide == false) {
@@ -320,7 +676,31 @@ void ResultsFormatter::writeMeshDetails(Mesh* mesh) {
     fs.close();
 }
 
-void ResultsFormatter::writeProgression(unsigned int iteration, const std::vector<CellResults*>& results) {
+std::vector<double> ResultsFormatter::sumProgression(const std::vector<CellResults*>& results) const {
+    auto config = Config::getInstance();
+    auto normalizer = config->getNormalizer();
+    const auto& gases = config->getGases();
+
+    // number of cells, then for each gas: number of particles, temperature, pressure, flow
+    std::vector<double> sums(1 + gases.size() * 6, 0.0);
+    sums[0] = results.size();
+    for (const auto& result : results) {
+        for (auto gi = 0; gi < gases.size(); gi++) {
+            double* gasSums = sums.data() + 1 + gi * 6;
+            double density = normalizer->restore(result->getDensity(gi), Normalizer::Type::DENSITY);
+            gasSums[0] += density * result->getVolume();
+            gasSums[1] += normalizer->restore(result->getTemp(gi), Normalizer::Type::TEMPERATURE);
+            gasSums[2] += normalizer->restore(result->getPressure(gi), Normalizer::Type::PRESSURE);
+            const auto& flow = result->getFlow(gi);
+            gasSums[3] += flow.x();
+            gasSums[4] += flow.y();
+            gasSums[5] += flow.z();
+        }
+    }
+    return sums;
+}
+
+void ResultsFormatter::writeProgression(unsigned int iteration, const std::vector<double>& sums) {
     if (exists(_root) == false) {
         std::cout << "No such folder: " << _root << std::endl;
         return;
@@ -337,98 +717,66 @@ void ResultsFormatter::writeProgression(unsigned int iteration, const std::vecto
     fs << iteration;
 
     auto config = Config::getInstance();
-    auto normalizer = config->getNormalizer();
     const auto& gases = config->getGases();
 
-//    CellResults* rightResult = nullptr;
-//    auto pos = std::find_if(results.begin(), results.end(), [](CellResults* item) {
-//        return item->getId() == 104;
-//    });
-//    if (pos != results.end()) {
-//        rightResult = (*pos);
-//    }
-
-    std::vector<double> wholeNumber(gases.size(), 0.0);
-    std::vector<double> wholeTemperature(gases.size(), 0.0);
-    std::vector<double> wholePressure(gases.size(), 0.0);
-    std::vector<Vector3d> wholeFlow(gases.size(), Vector3d());
-    for (const auto& result : results) {
-        for (auto gi = 0; gi < gases.size(); gi++) {
-            double density = normalizer->restore(result->getDensity(gi), Normalizer::Type::DENSITY);
-            wholeNumber[gi] += density * result->getVolume();
-            wholeTemperature[gi] += normalizer->restore(result->getTemp(gi), Normalizer::Type::TEMPERATURE);
-            wholePressure[gi] += normalizer->restore(result->getPressure(gi), Normalizer::Type::PRESSURE);
-            wholeFlow[gi] += result->getFlow(gi);
-        }
-    }
+    auto cellsSize = sums[0];
     for (auto gi = 0; gi < gases.size(); gi++) {
-        fs << " " << wholeNumber[gi] / 6.022e23
-           << " " << wholeTemperature[gi] / results.size()
-           << " " << wholePressure[gi] / results.size()
-           << " " << wholeFlow[gi].module();
-
-//        if (rightResult != nullptr) {
-//            Vector3d rightFlow = rightResult->getFlow(gi);
-//            normalizer->restore(rightFlow.x(), Normalizer::Type::FLOW);
-//            normalizer->restore(rightFlow.y(), Normalizer::Type::FLOW);
-//            normalizer->restore(rightFlow.z(), Normalizer::Type::FLOW);
-//            fs << " " << rightFlow.x();
-//
-//            double pressure = rightResult->getPressure(gi);
-//            normalizer->restore(pressure, Normalizer::Type::PRESSURE);
-//            fs << " " << pressure;
-//        }
-    }
-
-
-//    // middle cell
-//    int middleCellId = 50;
-//    Vector3d heatflow;
-//    double tempLeft = 0, tempRight = 0, temp = 0;
-//    double hLeft = 0, hMiddle = 0, hRight = 0;
-//    for (const auto& result : results) {
-//        if (result->getId() == middleCellId - 1) {
-//            hLeft = result->getVolume();
-//            tempLeft = result->getTemp(0);
-//        }
-//        if (result->getId() == middleCellId + 1) {
-//            hRight = result->getVolume();
-//            tempRight = result->getTemp(0);
-//        }
-//        if (result->getId() == middleCellId) {
-//            hMiddle = result->getVolume();
-//            temp = result->getTemp(0);
-//            heatflow = result->getHeatFlow(0);
-//        }
-//    }
-//
-//    if (iteration >= 500) {
-//        double h = hLeft / 2 + hRight / 2 + hMiddle;
-//        double grad = (tempRight - tempLeft) / h;
-//        double coef = - 1.0 / std::sqrt(2) / M_PI / std::sqrt(temp) / grad * heatflow.x() / Config::getInstance()->getGases()[0].getMass();
-//        fs << " " << coef;
-//    } else {
-//        fs << " " << 0.0;
-//    }
-
-//    if (_lastResults.empty()) {
-//        _lastResults.resize(results.size(), new CellResults());
-//        fs << " " << 0.0;
-//    } else {
-//        double averageTempDiff = 0.0, averageTemp = 0.0, averageDenDiff = 0.0, averageDen = 0.0;
-//        for (auto i = 0; i < results.size(); i++) {
-//            averageDen += results[i]->getDensity(0);
-//            averageDenDiff += results[i]->getDensity(0) - _lastResults[i]->getDensity(0);
-//            averageTemp += results[i]->getTemp(0);
-//            averageTempDiff += results[i]->getTemp(0) - _lastResults[i]->getTemp(0);
-//        }
-//        double delta = std::max(std::abs(averageDenDiff / averageDen), std::abs(averageTempDiff / averageTemp));
-//        fs << " " << delta;
-//    }
-//    for (auto i = 0; i < results.size(); i++) {
-//        _lastResults[i]->setFromResults(*results[i]);
-//    }
+        const double* gasSums = sums.data() + 1 + gi * 6;
+        fs << " " << gasSums[0] / 6.022e23
+           << " " << gasSums[1] / cellsSize
+           << " " << gasSums[2] / cellsSize
+           << " " << Vector3d(gasSums[3], gasSums[4], gasSums[5]).module();
+    }
+
+    fs << std::endl;
+
+    fs.close();
+}
+
+void ResultsFormatter::writeConvergence(unsigned int iteration, double l2, double linf) {
+    if (exists(_root) == false) {
+        std::cout << "No such folder: " << _root << std::endl;
+        return;
+    }
+
+    path mainPath{_root / _main};
+    if (exists(mainPath) == false) {
+        create_directory(mainPath);
+    }
+
+    // relative change of macroparameters per iteration over cells
+    path filePath = mainPath / ("convergence.txt");
+    std::ofstream fs(filePath.generic_string(), std::ios::out | std::ios::app);
+    fs << iteration << " " << l2 << " " << linf << std::endl;
+    fs.close();
+}
+
+void ResultsFormatter::writeProbe(unsigned int iteration, const std::string& name, const std::vector<CellResults*>& samples) {
+    if (exists(_root) == false) {
+        std::cout << "No such folder: " << _root << std::endl;
+        return;
+    }
+
+    path mainPath{_root / _main};
+    if (exists(mainPath) == false) {
+        create_directory(mainPath);
+    }
+
+    // one line per iteration: pressure, density, temperature and flow of every gas in every sample
+    path filePath = mainPath / ("probe_" + name + ".txt");
+    std::ofstream fs(filePath.generic_string(), std::ios::out | std::ios::app);
 
+    fs << iteration;
+    auto gasesSize = Config::getInstance()->getGases().size();
+    for (const auto& sample : samples) {
+        for (unsigned int gi = 0; gi < gasesSize; gi++) {
+            auto flow = getVector(Param::FLOW, sample, gi);
+            fs << " " << getScalar(Param::PRESSURE, sample, gi)
+               << " " << getScalar(Param::DENSITY, sample, gi)
+               << " " << getScalar(Param::TEMPERATURE, sample, gi)
+               << " " << flow.x() << " " << flow.y() << " " << flow.z();
+        }
+    }
     fs << std::endl;
 
     fs.close();
@@ -1,6 +1,9 @@
 #ifndef RGS_RESULTSPRINTER_H
 #define RGS_RESULTSPRINTER_H
 
+#include "utilities/Types.h"
+#include "mesh/Element.h"
+
 #include <string>
 #include <vector>
 
@@ -9,6 +12,12 @@ class CellResults;
 
 class ResultsFormatter {
 private:
+    enum class Format {
+        VTK,
+        VTU,
+        XDMF
+    };
+
     enum class Param {
         PRESSURE,
         DENSITY,
@@ -20,17 +29,51 @@ private:
     std::string _root;
     std::string _main;
 
+    Format _format;
+    int _compressionLevel;
+    double _tolerance;
+
+    // series of snapshots sharing one geometry file
+    std::vector<unsigned int> _seriesIterations;
+    std::size_t _seriesPointsSize;
+    std::size_t _seriesCellsSize;
+    std::size_t _seriesTopologySize;
+
     std::vector<Param> _scalarParams;
     std::vector<Param> _vectorParams;
 
-    std::vector<CellResults*> _lastResults;
-
 public:
     ResultsFormatter();
 
     void writeAll(unsigned int iteration, Mesh* mesh, const std::vector<CellResults*>& results);
     void writeMeshDetails(Mesh* mesh);
-    void writeProgression(unsigned int iteration, const std::vector<CellResults*>& results);
+    std::vector<double> sumProgression(const std::vector<CellResults*>& results) const;
+    void writeProgression(unsigned int iteration, const std::vector<double>& sums);
+    void writeConvergence(unsigned int iteration, double l2, double linf);
+    void writeProbe(unsigned int iteration, const std::string& name, const std::vector<CellResults*>& samples);
+
+private:
+    void writeVtk(const std::string& filename, Mesh* mesh, const std::vector<int>& elements, const std::vector<CellResults*>& results) const;
+
+    void writeVtu(const std::string& filename, Mesh* mesh, const std::vector<int>& elements, const std::vector<CellResults*>& results) const;
+
+    void writeXdmf(const std::string& folder, unsigned int iteration, Mesh* mesh, const std::vector<int>& elements, const std::vector<CellResults*>& results);
+
+    std::string getParamName(Param param, unsigned int gi) const;
+
+    double getScalar(Param param, const CellResults* results, unsigned int gi) const;
+
+    Vector3d getVector(Param param, const CellResults* results, unsigned int gi) const;
+
+    std::vector<double> getField(Param param, const std::vector<CellResults*>& results, unsigned int gi) const;
+
+    static std::string compress(const std::string& data, int level);
+
+    static int getCellType(Element::Type type);
+
+    static int getXdmfCellType(Element::Type type);
+
+    static bool isLittleEndian();
 
 };
 
@@ -0,0 +1,96 @@
+#include "ResultsWriter.h"
+#include "ResultsFormatter.h"
+
+ResultsWriter::ResultsWriter(ResultsFormatter* formatter, Mesh* mesh, std::size_t queueSize)
+        : _formatter(formatter), _mesh(mesh), _queueSize(queueSize), _isFinished(false) {
+    if (_queueSize > 0) {
+        _thread = std::thread(&ResultsWriter::run, this);
+    }
+}
+
+ResultsWriter::~ResultsWriter() {
+    stop();
+}
+
+void ResultsWriter::write(unsigned int iteration, const std::vector<CellResults*>& results) {
+
+    // copy results, cells keep going while snapshot is written
+    Snapshot snapshot;
+    snapshot.iteration = iteration;
+    snapshot.results.reserve(results.size());
+    for (auto cellResults : results) {
+        snapshot.results.push_back(*cellResults);
+    }
+
+    if (_queueSize == 0) {
+        writeSnapshot(snapshot);
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _pushCondition.wait(lock, [this] {
+        return _queue.size() < _queueSize || _exception != nullptr;
+    });
+    if (_exception != nullptr) {
+        std::rethrow_exception(_exception);
+    }
+    _queue.push_back(std::move(snapshot));
+    lock.unlock();
+    _popCondition.notify_one();
+}
+
+void ResultsWriter::finish() {
+    stop();
+    if (_exception != nullptr) {
+        std::rethrow_exception(_exception);
+    }
+}
+
+void ResultsWriter::stop() {
+    if (_thread.joinable() == true) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _isFinished = true;
+        }
+        _popCondition.notify_all();
+        _thread.join();
+    }
+}
+
+void ResultsWriter::run() {
+    while (true) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _popCondition.wait(lock, [this] {
+            return _queue.empty() == false || _isFinished == true;
+        });
+        if (_queue.empty() == true) {
+            break;
+        }
+
+        // write without lock, solver may push next snapshot meanwhile
+        Snapshot snapshot = std::move(_queue.front());
+        _queue.pop_front();
+        lock.unlock();
+
+        try {
+            writeSnapshot(snapshot);
+        } catch (...) {
+            lock.lock();
+            _exception = std::current_exception();
+            _queue.clear();
+            lock.unlock();
+            _pushCondition.notify_all();
+            break;
+        }
+        _pushCondition.notify_one();
+    }
+}
+
+void ResultsWriter::writeSnapshot(const Snapshot& snapshot) {
+    std::vector<CellResults*> results;
+    results.reserve(snapshot.results.size());
+    for (const auto& cellResults : snapshot.results) {
+        results.push_back(const_cast<CellResults*>(&cellResults));
+    }
+    _formatter->writeAll(snapshot.iteration, _mesh, results);
+}
@@ -0,0 +1,55 @@
+#ifndef RGS_RESULTSWRITER_H
+#define RGS_RESULTSWRITER_H
+
+#include "grid/CellResults.h"
+
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <exception>
+
+class Mesh;
+class ResultsFormatter;
+
+// writes snapshots of results in background thread, solver waits only when queue is full;
+// with zero queue size snapshots are written right away
+class ResultsWriter {
+private:
+    struct Snapshot {
+        unsigned int iteration;
+        std::vector<CellResults> results;
+    };
+
+    ResultsFormatter* _formatter;
+    Mesh* _mesh;
+    std::size_t _queueSize;
+
+    std::deque<Snapshot> _queue;
+    std::mutex _mutex;
+    std::condition_variable _pushCondition;
+    std::condition_variable _popCondition;
+    bool _isFinished;
+    std::exception_ptr _exception;
+    std::thread _thread;
+
+public:
+    ResultsWriter(ResultsFormatter* formatter, Mesh* mesh, std::size_t queueSize);
+
+    ~ResultsWriter();
+
+    void write(unsigned int iteration, const std::vector<CellResults*>& results);
+
+    void finish();
+
+private:
+    void stop();
+
+    void run();
+
+    void writeSnapshot(const Snapshot& snapshot);
+};
+
+
+#endif //RGS_RESULTSWRITER_H
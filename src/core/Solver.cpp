@@ -5,54 +5,118 @@
 #include "utilities/Parallel.h"
 #include "utilities/Utils.h"
 #include "utilities/SerializationUtils.h"
+#include "utilities/PrecisionUtils.h"
 #include "mesh/MeshParser.h"
+#include "mesh/MeshCache.h"
 #include "ResultsFormatter.h"
+#include "ResultsWriter.h"
+#include "Checkpoint.h"
 #include "KeyboardManager.h"
 
+#include <iostream>
 #include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <numeric>
+#include <limits>
+#include <algorithm>
+#include <cmath>
 #include <stdexcept>
 
 Solver::Solver() {
     _config = Config::getInstance();
+    _mesh = nullptr;
     _formatter = new ResultsFormatter();
+    _writer = nullptr;
+    _checkpoint = nullptr;
+    _startIteration = 0;
     _keyboard = KeyboardManager::getInstance();
+    _convergenceIteration = 0;
+    _convergedChecks = 0;
 }
 
 void Solver::init() {
     Mesh* mesh = nullptr;
 
     if (Parallel::isSingle() == false) {
+        std::vector<std::string> buffers;
         if (Parallel::isMaster() == true) {
 
-            // load mesh
-            mesh = MeshParser::getInstance().loadMesh(_config->getMeshFilename(), _config->getMeshUnits());
-            mesh->init();
+            // load mesh, master keeps whole mesh for output
+            _mesh = loadMesh();
 
-            // send to other processes
+            // split main elements by processes, extra partitions of mesh go round to existing processes
+            std::vector<std::vector<int>> elementIds(Parallel::getSize());
+            for (int ei = 0; ei < _mesh->getElementsSize(); ei++) {
+                auto processId = _mesh->getProcessId(ei);
+                if (_mesh->isMain(ei) == true && processId >= 0) {
+                    if (processId >= Parallel::getSize()) {
+                        processId %= Parallel::getSize();
+                        _mesh->setProcessId(ei, processId);
+                    }
+                    elementIds[processId].push_back(_mesh->getElementId(ei));
+                }
+            }
+
+            // each process gets only its elements with halo, border elements and needed nodes
+            mesh = _mesh->createSubmesh(elementIds[0]);
+            buffers.emplace_back();
             for (int processor = 1; processor < Parallel::getSize(); processor++) {
-                Parallel::send(SerializationUtils::serialize(mesh), processor, Parallel::COMMAND_MESH);
+                Mesh* submesh = _mesh->createSubmesh(elementIds[processor]);
+                buffers.push_back(SerializationUtils::serialize(submesh));
+                delete submesh;
             }
-        } else {
+        }
 
-            // get mesh from master process
-            SerializationUtils::deserialize(Parallel::recv(0, Parallel::COMMAND_MESH), mesh);
+        // send submeshes to other processes
+        std::string buffer = Parallel::scatter(buffers, 0);
+        if (Parallel::isMaster() == false) {
+            SerializationUtils::deserialize(buffer, mesh);
             mesh->resetMaps();
         }
     } else {
 
         // load mesh
-        mesh = MeshParser::getInstance().loadMesh(_config->getMeshFilename(), _config->getMeshUnits());
-        mesh->init();
+        _mesh = loadMesh();
+        mesh = _mesh;
     }
 
-    // write details on generated mesh
+    // write details on generated mesh, snapshots are written by master only
     if (Parallel::isMaster() == true) {
-        _formatter->writeMeshDetails(mesh);
+        _formatter->writeMeshDetails(_mesh);
+        _writer = new ResultsWriter(_formatter, _mesh, _config->getOutputQueueSize());
     }
 
-    // init all
+    // init all, either from scratch or from saved values
     _grid = new Grid(mesh);
-    _grid->init();
+    if (_config->getRestartFolder().empty() == true) {
+        _grid->init();
+    } else {
+        _startIteration = Checkpoint(_config->getRestartFolder()).read(_grid);
+        if (Parallel::isMaster() == true) {
+            std::cout << "Restart from iteration " << _startIteration << std::endl;
+        }
+    }
+    if (_config->getCheckpointEachIteration() > 0) {
+        _checkpoint = new Checkpoint(_config->getCheckpointFolder());
+    }
+
+    // probe cells are found on whole mesh by master
+    if (_config->getProbes().empty() == false) {
+        if (Parallel::isMaster() == true) {
+            _probeCellIds = locateProbes();
+        }
+        if (Parallel::isSingle() == false) {
+            std::string buffer;
+            if (Parallel::isMaster() == true) {
+                buffer = SerializationUtils::serialize(_probeCellIds);
+            }
+            Parallel::broadcast(buffer, 0);
+            if (Parallel::isMaster() == false) {
+                SerializationUtils::deserialize(buffer, _probeCellIds);
+            }
+        }
+    }
 
     // initiate integral
     if (_config->isUsingIntegral()) {
@@ -71,22 +135,57 @@ void Solver::run() {
         std::cout << std::endl;
     }
 
+    try {
+        iterate();
+    } catch (...) {
+
+        // snapshots already given to writer are written before run is aborted
+        if (_writer != nullptr) {
+            try {
+                _writer->finish();
+            } catch (...) {
+                // first exception is reported
+            }
+        }
+        throw;
+    }
+
+    if (Parallel::isMaster() == true) {
+        _writer->finish();
+        std::cout << std::endl << "Done" << std::endl;
+    }
+}
+
+void Solver::iterate() {
+
     // write initial results
-    writeResults(0);
+    writeResults(_startIteration);
+    writeProgression(_startIteration);
+    writeProbes(_startIteration);
 
     unsigned int maxIterations = _config->getMaxIterations();
-    for (unsigned int iteration = 1; iteration <= maxIterations; iteration++) {
+    for (unsigned int iteration = _startIteration + 1; iteration <= maxIterations; iteration++) {
+
+        // state of std::rand can't be saved, so with checkpoints it depends only on iteration
+        if (_checkpoint != nullptr || _startIteration > 0) {
+            std::srand(iteration);
+        }
 
         // sync grid
         if (Parallel::isSingle() == false) {
+            auto start = std::chrono::steady_clock::now();
             _grid->sync();
+            addPhaseTime(Phase::SYNC, start);
         }
 
         // transfer
+        auto transferStart = std::chrono::steady_clock::now();
         _grid->computeTransfer();
+        addPhaseTime(Phase::TRANSFER, transferStart);
 
         // integral
         if (_config->isUsingIntegral()) {
+            auto start = std::chrono::steady_clock::now();
             int gasesSize = _config->getGases().size();
             if (gasesSize == 1) {
                 _grid->computeIntegral(0, 0);
@@ -98,24 +197,31 @@ void Solver::run() {
                 _grid->computeIntegral(0, 1);
                 _grid->computeIntegral(0, 2);
             }
+            addPhaseTime(Phase::INTEGRAL, start);
         }
 
         // beta decay
         if (_config->isUsingBetaDecay()) {
+            auto start = std::chrono::steady_clock::now();
             const auto& betaChains = _config->getBetaChains();
             for (const auto& betaChain : betaChains) {
                 _grid->computeBetaDecay(betaChain.getGasIndex1(), betaChain.getGasIndex2(), betaChain.getLambda1());
                 _grid->computeBetaDecay(betaChain.getGasIndex2(), betaChain.getGasIndex3(), betaChain.getLambda2());
             }
+            addPhaseTime(Phase::BETA_DECAY, start);
         }
 
         // sync grid
         if (Parallel::isSingle() == false) {
+            auto start = std::chrono::steady_clock::now();
             _grid->sync();
+            addPhaseTime(Phase::SYNC, start);
         }
 
         // transfer
+        transferStart = std::chrono::steady_clock::now();
         _grid->computeTransfer();
+        addPhaseTime(Phase::TRANSFER, transferStart);
 
         // check grid
         _grid->check();
@@ -124,6 +230,37 @@ void Solver::run() {
         if (iteration % _config->getOutEachIteration() == 0) {
             writeResults(iteration);
         }
+        unsigned int progressionEachIteration = _config->getProgressionEachIteration();
+        if (progressionEachIteration > 0 && iteration % progressionEachIteration == 0) {
+            writeProgression(iteration);
+        }
+        unsigned int probeEachIteration = _config->getProbeEachIteration();
+        if (probeEachIteration > 0 && iteration % probeEachIteration == 0) {
+            writeProbes(iteration);
+        }
+
+        // stop when solution doesn't change anymore, last state is written out
+        unsigned int convergenceEachIteration = _config->getConvergenceEachIteration();
+        if (convergenceEachIteration > 0 && iteration % convergenceEachIteration == 0 && checkConvergence(iteration) == true) {
+            if (iteration % _config->getOutEachIteration() != 0) {
+                writeResults(iteration);
+            }
+            if (Parallel::isMaster() == true) {
+                std::cout << std::endl << "Converged at iteration " << iteration << std::endl;
+            }
+            break;
+        }
+
+        // save state to continue later
+        if (_checkpoint != nullptr && iteration % _config->getCheckpointEachIteration() == 0) {
+            _checkpoint->write(iteration, _grid);
+        }
+
+        // move cells between processes if their work differs too much
+        unsigned int balanceEachIteration = _config->getBalanceEachIteration();
+        if (Parallel::isSingle() == false && balanceEachIteration > 0 && iteration % balanceEachIteration == 0) {
+            balance();
+        }
 
         if (Parallel::isMaster() == true) {
             bool isPrintingProgress = true;
@@ -144,9 +281,6 @@ void Solver::run() {
             }
         }
     }
-    if (Parallel::isMaster() == true) {
-        std::cout << std::endl << "Done" << std::endl;
-    }
 }
 
 void Solver::writeResults(int iteration) {
@@ -159,26 +293,305 @@ void Solver::writeResults(int iteration) {
     }
 
     if (Parallel::isSingle() == false) {
+
+        // collect params on master, then unite grids
+        auto buffers = Parallel::gather(packResults(results), 0);
         if (Parallel::isMaster() == true) {
+            std::vector<std::shared_ptr<CellResults>> otherResults;
+            for (int processor = 1; processor < Parallel::getSize(); processor++) {
+                unpackResults(buffers[processor], otherResults);
+            }
+            for (const auto& tempResults : otherResults) {
+                results.push_back(tempResults.get());
+            }
 
-            // receive params from master, then unite grids
+            _writer->write(iteration, results);
+        }
+    } else {
+        _writer->write(iteration, results);
+    }
+}
+
+void Solver::writeProgression(int iteration) {
+    std::vector<CellResults*> results;
+    for (const auto& cell : _grid->getCells()) {
+        if (cell->getType() == NormalCell::Type::NORMAL) {
+            auto normalCell = dynamic_cast<NormalCell*>(cell.get());
+            results.push_back(normalCell->getResults());
+        }
+    }
+
+    // only sums over cells are needed, so they are reduced instead of gathering all results
+    auto sums = _formatter->sumProgression(results);
+    if (Parallel::isSingle() == false) {
+        Parallel::allreduce(sums, Parallel::Operation::SUM);
+    }
+    if (Parallel::isMaster() == true) {
+        _formatter->writeProgression(iteration, sums);
+    }
+}
+
+bool Solver::checkConvergence(int iteration) {
+
+    // sum of squares and count of changes, count of cells without last values, max change
+    std::vector<double> sums(3, 0.0);
+    double maxChange = 0.0;
+    for (const auto& cell : _grid->getCells()) {
+        if (cell->getType() == NormalCell::Type::NORMAL) {
+            double change = 0.0;
+            if (dynamic_cast<NormalCell*>(cell.get())->getChange(change) == false) {
+                sums[2] += 1.0;
+                continue;
+            }
+            sums[0] += change * change;
+            sums[1] += 1.0;
+            maxChange = std::max(maxChange, change);
+        }
+    }
+    if (Parallel::isSingle() == false) {
+        Parallel::allreduce(sums, Parallel::Operation::SUM);
+        maxChange = Parallel::allreduce(maxChange, Parallel::Operation::MAX);
+    }
+
+    // first check only keeps macroparameters
+    unsigned int lastIteration = _convergenceIteration;
+    _convergenceIteration = iteration;
+    if (lastIteration == 0) {
+        return false;
+    }
+
+    // changes are taken per iteration
+    double iterations = iteration - lastIteration;
+    double l2 = sums[1] > 0.0 ? std::sqrt(sums[0] / sums[1]) / iterations : 0.0;
+    double linf = maxChange / iterations;
+    if (Parallel::isMaster() == true) {
+        _formatter->writeConvergence(iteration, l2, linf);
+    }
+
+    // check with cells moved by rebalance doesn't see them, so it isn't counted
+    if (sums[2] > 0.0) {
+        return false;
+    }
+    if (linf < _config->getConvergenceTolerance()) {
+        _convergedChecks++;
+    } else {
+        _convergedChecks = 0;
+    }
+    return _convergedChecks > 0 && _convergedChecks >= _config->getConvergenceChecks();
+}
+
+void Solver::writeProbes(int iteration) {
+    if (_probeCellIds.empty() == true) {
+        return;
+    }
+
+    // each process gives results of its probe cells only
+    std::vector<int> ids;
+    for (const auto& cellIds : _probeCellIds) {
+        ids.insert(ids.end(), cellIds.begin(), cellIds.end());
+    }
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+    std::vector<CellResults*> results;
+    for (auto id : ids) {
+        auto cell = _grid->getCellById(id);
+        if (cell != nullptr && cell->getType() == NormalCell::Type::NORMAL) {
+            results.push_back(dynamic_cast<NormalCell*>(cell)->getResults());
+        }
+    }
+
+    std::vector<std::shared_ptr<CellResults>> otherResults;
+    if (Parallel::isSingle() == false) {
+        auto buffers = Parallel::gather(packResults(results), 0);
+        if (Parallel::isMaster() == true) {
             for (int processor = 1; processor < Parallel::getSize(); processor++) {
-                std::vector<CellResults*> resultsBuffer;
-                SerializationUtils::deserialize(Parallel::recv(processor, Parallel::COMMAND_RESULT_PARAMS), resultsBuffer);
-                for (auto tempResults : resultsBuffer) {
-                    results.push_back(tempResults);
-                }
+                unpackResults(buffers[processor], otherResults);
             }
+        }
+    }
+    if (Parallel::isMaster() == false) {
+        return;
+    }
+    for (const auto& tempResults : otherResults) {
+        results.push_back(tempResults.get());
+    }
+
+    std::map<int, CellResults*> resultsMap;
+    for (auto cellResults : results) {
+        resultsMap[cellResults->getId()] = cellResults;
+    }
+    const auto& probes = _config->getProbes();
+    for (std::size_t pi = 0; pi < probes.size(); pi++) {
+        std::vector<CellResults*> samples;
+        for (auto id : _probeCellIds[pi]) {
+            samples.push_back(resultsMap.at(id));
+        }
+        _formatter->writeProbe(iteration, probes[pi].getName(), samples);
+    }
+}
 
-            _formatter->writeAll(iteration, _grid->getMesh(), results);
-            _formatter->writeProgression(iteration, results);
-        } else {
+std::vector<std::vector<int>> Solver::locateProbes() const {
+    std::vector<Vector3d> centers;
+    std::vector<int> centerIds;
+    double units = _config->getMeshUnits();
+    for (int ei = 0; ei < _mesh->getElementsSize(); ei++) {
+        if (_mesh->isMain(ei) == false) {
+            continue;
+        }
+        Vector3d center;
+        auto nodes = _mesh->getElementNodes(ei);
+        for (auto node : nodes) {
+            center += _mesh->getNodePosition(node);
+        }
+        centers.push_back(center / (nodes.size() * units));
+        centerIds.push_back(_mesh->getElementId(ei));
+    }
+
+    std::vector<std::vector<int>> probeCellIds;
+    for (const auto& probe : _config->getProbes()) {
+        std::vector<int> cellIds;
+        for (auto id : probe.getElementIds()) {
+            if (_mesh->hasElement(id) == false || _mesh->isMain(_mesh->getElementIndex(id)) == false) {
+                throw std::runtime_error("probe " + probe.getName() + ": no main element with id " + std::to_string(id));
+            }
+            cellIds.push_back(id);
+        }
 
-            // send params to master
-            Parallel::send(SerializationUtils::serialize(results), 0, Parallel::COMMAND_RESULT_PARAMS);
+        // point is given to cell with nearest center
+        for (const auto& point : probe.getPoints()) {
+            int nearestId = 0;
+            double minDistance = std::numeric_limits<double>::max();
+            for (std::size_t ci = 0; ci < centers.size(); ci++) {
+                double distance = (centers[ci] - point).moduleSquare();
+                if (distance < minDistance) {
+                    minDistance = distance;
+                    nearestId = centerIds[ci];
+                }
+            }
+            cellIds.push_back(nearestId);
         }
+        probeCellIds.push_back(cellIds);
+    }
+    return probeCellIds;
+}
+
+Mesh* Solver::loadMesh() const {
+    const auto& filename = _config->getMeshFilename();
+    double units = _config->getMeshUnits();
+    if (_config->getMeshCacheFolder().empty() == true) {
+        Mesh* mesh = MeshParser::getInstance().loadMesh(filename, units);
+        mesh->init();
+        return mesh;
+    }
+
+    // preprocessed mesh is taken from cache, if there is none it is made and saved for next runs
+    MeshCache cache(_config->getMeshCacheFolder(), filename, units);
+    Mesh* mesh = cache.read();
+    if (mesh != nullptr) {
+        std::cout << "Mesh is read from cache" << std::endl;
     } else {
-        _formatter->writeAll(iteration, _grid->getMesh(), results);
-        _formatter->writeProgression(iteration, results);
+        mesh = MeshParser::getInstance().loadMesh(filename, units);
+        mesh->init();
+        cache.write(mesh);
+    }
+    return mesh;
+}
+
+void Solver::balance() {
+    std::vector<double> phaseTimes = {
+            _phaseTimes[Phase::SYNC],
+            _phaseTimes[Phase::TRANSFER],
+            _phaseTimes[Phase::INTEGRAL],
+            _phaseTimes[Phase::BETA_DECAY]
+    };
+    _phaseTimes.clear();
+
+    // work time (all phases except sync) of each process is known to everyone
+    double workTime = phaseTimes[1] + phaseTimes[2] + phaseTimes[3];
+    std::vector<double> workTimes = Parallel::allgather(workTime);
+
+    Parallel::allreduce(phaseTimes, Parallel::Operation::MAX);
+    if (Parallel::isMaster() == true) {
+        std::cout << std::endl << "Balance: max times (sync, transfer, integral, beta decay) = " << Utils::toString(phaseTimes) << " s" << std::endl;
+    }
+
+    double maxTime = *std::max_element(workTimes.begin(), workTimes.end());
+    double meanTime = std::accumulate(workTimes.begin(), workTimes.end(), 0.0) / workTimes.size();
+    double imbalance = meanTime > 0.0 ? maxTime / meanTime : 1.0;
+    if (imbalance > _config->getBalanceThreshold()) {
+        int movedCells = _grid->rebalance(workTimes);
+        if (Parallel::isMaster() == true) {
+            std::cout << "Balance: imbalance = " << imbalance << "; moved cells = " << movedCells << std::endl;
+        }
+    }
+}
+
+void Solver::addPhaseTime(Phase phase, const std::chrono::steady_clock::time_point& start) {
+    auto now = std::chrono::steady_clock::now();
+    _phaseTimes[phase] += std::chrono::duration<double>(now - start).count();
+}
+
+std::string Solver::packResults(const std::vector<CellResults*>& results) const {
+    auto precision = _config->getTransportPrecision();
+    auto gasesSize = _config->getGases().size();
+
+    // params are packed by columns, so each column is scaled separately in half precision
+    std::vector<std::vector<double>> columns(gasesSize * 9 + 1, std::vector<double>(results.size()));
+    std::vector<int> ids(results.size());
+    for (std::size_t i = 0; i < results.size(); i++) {
+        ids[i] = results[i]->getId();
+        for (unsigned int gi = 0; gi < gasesSize; gi++) {
+            const auto& flow = results[i]->getFlow(gi);
+            const auto& heatFlow = results[i]->getHeatFlow(gi);
+            columns[gi * 9 + 0][i] = results[i]->getPressure(gi);
+            columns[gi * 9 + 1][i] = results[i]->getDensity(gi);
+            columns[gi * 9 + 2][i] = results[i]->getTemp(gi);
+            columns[gi * 9 + 3][i] = flow.x();
+            columns[gi * 9 + 4][i] = flow.y();
+            columns[gi * 9 + 5][i] = flow.z();
+            columns[gi * 9 + 6][i] = heatFlow.x();
+            columns[gi * 9 + 7][i] = heatFlow.y();
+            columns[gi * 9 + 8][i] = heatFlow.z();
+        }
+        columns.back()[i] = results[i]->getVolume();
+    }
+
+    auto size = static_cast<int>(results.size());
+    std::string buffer(reinterpret_cast<const char*>(&size), sizeof(int));
+    buffer.append(reinterpret_cast<const char*>(ids.data()), ids.size() * sizeof(int));
+    for (const auto& column : columns) {
+        PrecisionUtils::pack(column.data(), column.size(), precision, buffer);
+    }
+    return buffer;
+}
+
+void Solver::unpackResults(const std::string& buffer, std::vector<std::shared_ptr<CellResults>>& results) const {
+    auto precision = _config->getTransportPrecision();
+    auto gasesSize = _config->getGases().size();
+
+    const char* position = buffer.data();
+    int size;
+    std::memcpy(&size, position, sizeof(int));
+    position += sizeof(int);
+
+    std::vector<int> ids(static_cast<std::size_t>(size));
+    std::memcpy(ids.data(), position, ids.size() * sizeof(int));
+    position += ids.size() * sizeof(int);
+
+    std::vector<std::vector<double>> columns(gasesSize * 9 + 1, std::vector<double>(ids.size()));
+    for (auto& column : columns) {
+        position = PrecisionUtils::unpack(position, precision, column.data(), column.size());
+    }
+
+    for (std::size_t i = 0; i < ids.size(); i++) {
+        auto cellResults = std::make_shared<CellResults>(ids[i]);
+        for (unsigned int gi = 0; gi < gasesSize; gi++) {
+            Vector3d flow(columns[gi * 9 + 3][i], columns[gi * 9 + 4][i], columns[gi * 9 + 5][i]);
+            Vector3d heatFlow(columns[gi * 9 + 6][i], columns[gi * 9 + 7][i], columns[gi * 9 + 8][i]);
+            cellResults->set(gi, columns[gi * 9 + 0][i], columns[gi * 9 + 1][i], columns[gi * 9 + 2][i], flow, heatFlow);
+        }
+        cellResults->setVolume(columns.back()[i]);
+        results.push_back(cellResults);
     }
 }
@@ -5,11 +5,27 @@
 #include "parameters/ImpulseSphere.h"
 #include "grid/Grid.h"
 
+#include <map>
+#include <vector>
+#include <chrono>
+#include <memory>
+
 class NormalCell;
+class CellResults;
 class ResultsFormatter;
+class ResultsWriter;
+class Checkpoint;
 class KeyboardManager;
 
 class Solver {
+private:
+    enum class Phase {
+        SYNC,
+        TRANSFER,
+        INTEGRAL,
+        BETA_DECAY
+    };
+
 public:
     Solver();
 
@@ -19,11 +35,43 @@ public:
 
     void writeResults(int iteration);
 
+    void writeProgression(int iteration);
+
+    void writeProbes(int iteration);
+
+    // returns true when change of macroparameters stays below tolerance for given number of checks
+    bool checkConvergence(int iteration);
+
 private:
     Config* _config;
+    Mesh* _mesh;
     Grid* _grid;
     ResultsFormatter* _formatter;
+    ResultsWriter* _writer;
+    Checkpoint* _checkpoint;
+    unsigned int _startIteration;
+    std::vector<std::vector<int>> _probeCellIds;
     KeyboardManager* _keyboard;
+
+    unsigned int _convergenceIteration;
+    unsigned int _convergedChecks;
+
+    std::map<Phase, double> _phaseTimes;
+
+    // all iterations with output, writer is finished by run
+    void iterate();
+
+    Mesh* loadMesh() const;
+
+    void balance();
+
+    std::vector<std::vector<int>> locateProbes() const;
+
+    void addPhaseTime(Phase phase, const std::chrono::steady_clock::time_point& start);
+
+    std::string packResults(const std::vector<CellResults*>& results) const;
+
+    void unpackResults(const std::string& buffer, std::vector<std::shared_ptr<CellResults>>& results) const;
 };
 
 #endif //RGS_SOLVER_H
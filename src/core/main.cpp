@@ -43,21 +43,23 @@ int main(int argc, char* argv[]) {
 
     // Create config
     if (Parallel::isSingle() == false) {
+        std::string buffer;
         if (Parallel::isMaster() == true) {
 
             // load config
             Config::getInstance()->load(argv[argc - 1]);
             Config::getInstance()->init();
+            buffer = SerializationUtils::serialize(Config::getInstance());
+        }
 
-            // send to other processes
-            for (int processor = 1; processor < Parallel::getSize(); processor++) {
-                Parallel::send(SerializationUtils::serialize(Config::getInstance()), processor, Parallel::COMMAND_CONFIG);
-            }
-        } else {
+        // send to other processes
+        Parallel::broadcast(buffer, 0);
+
+        if (Parallel::isMaster() == false) {
 
-            // get mesh from master process
+            // get config from master process
             Config* config = nullptr;
-            SerializationUtils::deserialize(Parallel::recv(0, Parallel::COMMAND_CONFIG), config);
+            SerializationUtils::deserialize(buffer, config);
             config->getImpulseSphere()->init();
             Config::setInstance(config);
         }
@@ -1,5 +1,4 @@
 #include "BaseCell.h"
-#include "CellConnection.h"
 #include "parameters/ImpulseSphere.h"
 #include "parameters/Gas.h"
 #include "core/Config.h"
@@ -24,7 +23,3 @@ void BaseCell::check() {
         }
     }
 }
-
-void BaseCell::addConnection(CellConnection* connection) {
-    _connections.emplace_back(connection);
-}
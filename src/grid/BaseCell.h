@@ -6,7 +6,7 @@
 #include <vector>
 #include <memory>
 
-class CellConnection;
+class CellConnections;
 
 class BaseCell {
 public:
@@ -19,11 +19,12 @@ public:
 protected:
     Type _type;
     int _id;
+    int _index;
+    int _level;
     std::vector<std::vector<double>> _values;
-    std::vector<std::shared_ptr<CellConnection>> _connections;
 
 public:
-    BaseCell(Type type, int id) : _type(type), _id(id) {}
+    BaseCell(Type type, int id) : _type(type), _id(id), _index(-1), _level(0) {}
 
     int getId() const {
         return _id;
@@ -33,21 +34,33 @@ public:
         return _type;
     }
 
-    std::vector<std::vector<double>>& getValues() {
-        return _values;
+    // index of cell in grid, it addresses connections of cell
+    int getIndex() const {
+        return _index;
     }
 
+    void setIndex(int index) {
+        _index = index;
+    }
+
+    // with local time stepping cell is updated once in 2^level smallest timesteps
+    int getLevel() const {
+        return _level;
+    }
 
-    const std::vector<std::shared_ptr<CellConnection>>& getConnections() const {
-        return _connections;
+    void setLevel(int level) {
+        _level = level;
+    }
+
+    std::vector<std::vector<double>>& getValues() {
+        return _values;
     }
 
-    void addConnection(CellConnection* connection);
 
     void check();
 
     virtual void init() = 0;
-    virtual void computeTransfer() = 0;
+    virtual void computeTransfer(const CellConnections& connections) = 0;
     virtual void computeIntegral(int gi0, int gi1) = 0;
     virtual void computeBetaDecay(int gi0, int gi1, double lambda) = 0;
 
@@ -1,5 +1,5 @@
 #include "BorderCell.h"
-#include "CellConnection.h"
+#include "CellConnections.h"
 
 #include <stdexcept>
 
@@ -24,10 +24,13 @@ void BorderCell::init() {
     }
 }
 
-void BorderCell::computeTransfer() {
-    if (_connections.size() != 1) {
+void BorderCell::computeTransfer(const CellConnections& connections) {
+    int ci = connections.getBegin(_index);
+    if (connections.getEnd(_index) - ci != 1) {
         throw std::runtime_error("wrong border connection");
     }
+    Vector3d normal = connections.getNormalVector(ci);
+    BaseCell* cell = connections.getNeighbor(ci);
 
     auto config = Config::getInstance();
     const auto& gases = config->getGases();
@@ -38,19 +41,19 @@ void BorderCell::computeTransfer() {
                 throw std::runtime_error("undefined border type");
 
             case BorderType::DIFFUSE:
-                computeTransferDiffuse(gi);
+                computeTransferDiffuse(gi, normal, cell);
                 break;
 
             case BorderType::MIRROR:
-                computeTransferMirror(gi);
+                computeTransferMirror(gi, normal, cell);
                 break;
 
             case BorderType::PRESSURE:
-                computeTransferPressure(gi);
+                computeTransferPressure(gi, normal, cell);
                 break;
 
             case BorderType::FLOW:
-                computeTransferFlow(gi);
+                computeTransferFlow(gi, normal, cell);
                 break;
         }
     }
@@ -64,16 +67,16 @@ void BorderCell::computeBetaDecay(int gi0, int gi1, double lambda) {
     // nothing
 }
 
-void BorderCell::computeTransferDiffuse(unsigned int gi) {
+void BorderCell::computeTransferDiffuse(unsigned int gi, const Vector3d& normal, BaseCell* cell) {
     auto config = Config::getInstance();
     const auto& gases = config->getGases();
     const auto& impulses = config->getImpulseSphere()->getImpulses();
 
     double cUp = 0.0, cDown = 0.0;
     for (unsigned int ii = 0; ii < impulses.size(); ii++) {
-        double projection = impulses[ii].scalar(_connections[0]->getNormal12());
+        double projection = impulses[ii].scalar(normal);
         if (projection < 0.0) {
-            cUp += -projection * _connections[0]->getSecond()->getValues()[gi][ii];
+            cUp += -projection * cell->getValues()[gi][ii];
         } else {
             cDown += projection * _cacheExp[gi][ii];
         }
@@ -81,25 +84,25 @@ void BorderCell::computeTransferDiffuse(unsigned int gi) {
 
     double h = cUp / cDown;
     for (unsigned int ii = 0; ii < impulses.size(); ii++) {
-        double projection = impulses[ii].scalar(_connections[0]->getNormal12());
+        double projection = impulses[ii].scalar(normal);
         if (projection >= 0.0) {
             _values[gi][ii] = h * _cacheExp[gi][ii];
         }
     }
 }
 
-void BorderCell::computeTransferMirror(unsigned int gi) {
+void BorderCell::computeTransferMirror(unsigned int gi, const Vector3d& normal, BaseCell* cell) {
     auto config = Config::getInstance();
     const auto& gases = config->getGases();
     const auto& impulseSphere = config->getImpulseSphere();
     const auto& impulses = impulseSphere->getImpulses();
 
     for (unsigned int ii = 0; ii < impulses.size(); ii++) {
-        double projection = impulses[ii].scalar(_connections[0]->getNormal12());
+        double projection = impulses[ii].scalar(normal);
         if (projection >= 0.0) {
-            auto rii = impulseSphere->reverseIndex(ii, _connections[0]->getNormal12());
+            auto rii = impulseSphere->reverseIndex(ii, normal);
             if (rii >= 0) {
-                _values[gi][ii] = _connections[0]->getSecond()->getValues()[gi][rii];
+                _values[gi][ii] = cell->getValues()[gi][rii];
             } else {
                 _values[gi][ii] = 0.0;
             }
@@ -107,7 +110,7 @@ void BorderCell::computeTransferMirror(unsigned int gi) {
     }
 }
 
-void BorderCell::computeTransferPressure(unsigned int gi) {
+void BorderCell::computeTransferPressure(unsigned int gi, const Vector3d& normal, BaseCell* cell) {
     auto config = Config::getInstance();
     const auto& gases = config->getGases();
     const auto& impulseSphere = config->getImpulseSphere();
@@ -119,9 +122,9 @@ void BorderCell::computeTransferPressure(unsigned int gi) {
     }
     double cUp = cUp0, cDown = 0.0;
     for (unsigned int ii = 0; ii < impulses.size(); ii++) {
-        double projection = impulses[ii].scalar(_connections[0]->getNormal12());
+        double projection = impulses[ii].scalar(normal);
         if (projection< 0.0) {
-            cUp -= _connections[0]->getSecond()->getValues()[gi][ii];
+            cUp -= cell->getValues()[gi][ii];
         } else {
             cDown += _cacheExp[gi][ii];;
         }
@@ -130,14 +133,14 @@ void BorderCell::computeTransferPressure(unsigned int gi) {
     double h = cUp / cDown;
     if (h > 0) {
         for (unsigned int ii = 0; ii < impulses.size(); ii++) {
-            double projection = impulses[ii].scalar(_connections[0]->getNormal12());
+            double projection = impulses[ii].scalar(normal);
             if (projection >= 0.0) {
                 _values[gi][ii] = h * _cacheExp[gi][ii];
             }
         }
     } else {
         for (unsigned int ii = 0; ii < impulses.size(); ii++) {
-            double projection = impulses[ii].scalar(_connections[0]->getNormal12());
+            double projection = impulses[ii].scalar(normal);
             if (projection >= 0.0) {
                 _values[gi][ii] = 0.0;
             }
@@ -145,21 +148,21 @@ void BorderCell::computeTransferPressure(unsigned int gi) {
     }
 }
 
-void BorderCell::computeTransferFlow(unsigned int gi) {
+void BorderCell::computeTransferFlow(unsigned int gi, const Vector3d& normal, BaseCell* cell) {
     auto config = Config::getInstance();
     const auto& gases = config->getGases();
     const auto& impulseSphere = config->getImpulseSphere();
     const auto& impulses = impulseSphere->getImpulses();
 
-    double cUp0 = _boundaryParams.getFlow(gi).scalar(_connections[0]->getNormal12());
+    double cUp0 = _boundaryParams.getFlow(gi).scalar(normal);
     if (cUp0 > 0) {
         cUp0 /= impulseSphere->getDeltaImpulseQube();
     }
     double cUp = cUp0, cDown = 0.0;
     for (unsigned int ii = 0; ii < impulses.size(); ii++) {
-        double projection = impulses[ii].scalar(_connections[0]->getNormal12());
+        double projection = impulses[ii].scalar(normal);
         if (projection < 0.0) {
-            cUp += -projection * _connections[0]->getSecond()->getValues()[gi][ii];
+            cUp += -projection * cell->getValues()[gi][ii];
         } else {
             cDown += projection * _cacheExp[gi][ii];;
         }
@@ -168,14 +171,14 @@ void BorderCell::computeTransferFlow(unsigned int gi) {
     double h = cUp / cDown;
     if (h > 0) {
         for (unsigned int ii = 0; ii < impulses.size(); ii++) {
-            double projection = impulses[ii].scalar(_connections[0]->getNormal12());
+            double projection = impulses[ii].scalar(normal);
             if (projection >= 0.0) {
                 _values[gi][ii] = h * _cacheExp[gi][ii];;
             }
         }
     } else {
         for (unsigned int ii = 0; ii < impulses.size(); ii++) {
-            double projection = impulses[ii].scalar(_connections[0]->getNormal12());
+            double projection = impulses[ii].scalar(normal);
             if (projection >= 0.0) {
                 _values[gi][ii] = 0.0;
             }
@@ -35,17 +35,17 @@ public:
 
     void init() override;
 
-    void computeTransfer() override;
+    void computeTransfer(const CellConnections& connections) override;
 
     void computeIntegral(int gi0, int gi1) override;
 
     void computeBetaDecay(int gi0, int gi1, double lambda) override;
 
 private:
-    void computeTransferDiffuse(unsigned int gi);
-    void computeTransferMirror(unsigned int gi);
-    void computeTransferPressure(unsigned int gi);
-    void computeTransferFlow(unsigned int gi);
+    void computeTransferDiffuse(unsigned int gi, const Vector3d& normal, BaseCell* cell);
+    void computeTransferMirror(unsigned int gi, const Vector3d& normal, BaseCell* cell);
+    void computeTransferPressure(unsigned int gi, const Vector3d& normal, BaseCell* cell);
+    void computeTransferFlow(unsigned int gi, const Vector3d& normal, BaseCell* cell);
 
 };
 
@@ -0,0 +1,48 @@
+#include "CellConnections.h"
+
+#include <algorithm>
+
+void CellConnections::clear() {
+    _cells.clear();
+    _offsets.clear();
+    _firsts.clear();
+    _neighbors.clear();
+    _squares.clear();
+    _normals.clear();
+}
+
+void CellConnections::add(int first, int second, double square, const Vector3d& normal12) {
+    _firsts.push_back(first);
+    _neighbors.push_back(second);
+    _squares.push_back(square);
+    _normals.insert(_normals.end(), {normal12.x(), normal12.y(), normal12.z()});
+}
+
+void CellConnections::build(std::vector<BaseCell*> cells) {
+    _cells = std::move(cells);
+
+    // counting sort of connections by first cell, stable for connections of the same cell
+    _offsets.assign(_cells.size() + 1, 0);
+    for (auto first : _firsts) {
+        _offsets[first + 1]++;
+    }
+    for (std::size_t ci = 0; ci < _cells.size(); ci++) {
+        _offsets[ci + 1] += _offsets[ci];
+    }
+
+    std::vector<int> positions(_offsets.begin(), _offsets.end() - 1);
+    std::vector<int> neighbors(_neighbors.size());
+    std::vector<double> squares(_squares.size());
+    std::vector<double> normals(_normals.size());
+    for (std::size_t i = 0; i < _firsts.size(); i++) {
+        auto position = positions[_firsts[i]]++;
+        neighbors[position] = _neighbors[i];
+        squares[position] = _squares[i];
+        std::copy(_normals.begin() + 3 * i, _normals.begin() + 3 * (i + 1), normals.begin() + 3 * position);
+    }
+    _neighbors = std::move(neighbors);
+    _squares = std::move(squares);
+    _normals = std::move(normals);
+    _firsts.clear();
+    _firsts.shrink_to_fit();
+}
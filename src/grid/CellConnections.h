@@ -0,0 +1,64 @@
+#ifndef RGS_CELLCONNECTIONS_H
+#define RGS_CELLCONNECTIONS_H
+
+#include "utilities/Types.h"
+
+#include <vector>
+
+class BaseCell;
+
+// connections of all cells of grid in CSR form: connections of cell with index ci are from
+// getBegin(ci) to getEnd(ci), each keeps index of neighbor cell, square and normal from cell to neighbor
+class CellConnections {
+private:
+    std::vector<BaseCell*> _cells;
+    std::vector<int> _offsets;
+    std::vector<int> _firsts;
+    std::vector<int> _neighbors;
+    std::vector<double> _squares;
+    std::vector<double> _normals;
+
+public:
+    CellConnections() = default;
+
+    void clear();
+
+    // connections may be added in any order of cells, order of connections of each cell is kept by build
+    void add(int first, int second, double square, const Vector3d& normal12);
+
+    void build(std::vector<BaseCell*> cells);
+
+    int getBegin(int ci) const {
+        return _offsets[ci];
+    }
+
+    int getEnd(int ci) const {
+        return _offsets[ci + 1];
+    }
+
+    int getNeighborIndex(int index) const {
+        return _neighbors[index];
+    }
+
+    BaseCell* getNeighbor(int index) const {
+        return _cells[_neighbors[index]];
+    }
+
+    double getSquare(int index) const {
+        return _squares[index];
+    }
+
+    // x, y, z of normal from cell to neighbor
+    const double* getNormal(int index) const {
+        return _normals.data() + 3 * index;
+    }
+
+    Vector3d getNormalVector(int index) const {
+        const double* normal = getNormal(index);
+        return Vector3d(normal[0], normal[1], normal[2]);
+    }
+
+};
+
+
+#endif //RGS_CELLCONNECTIONS_H
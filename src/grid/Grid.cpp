@@ -2,7 +2,6 @@
 #include "NormalCell.h"
 #include "BorderCell.h"
 #include "ParallelCell.h"
-#include "CellConnection.h"
 #include "mesh/Mesh.h"
 #include "parameters/Gas.h"
 #include "parameters/ImpulseSphere.h"
@@ -11,35 +10,104 @@
 #include "utilities/Parallel.h"
 #include "utilities/SerializationUtils.h"
 #include "utilities/Normalizer.h"
+#include "utilities/PrecisionUtils.h"
 #include "integral/ci.hpp"
 #include "integral/ci_impl.hpp"
 
 #include <map>
+#include <set>
+#include <cstdlib>
+#include <cmath>
+#include <numeric>
+#include <algorithm>
 #include <stdexcept>
 
 #include <unistd.h>
 
-Grid::Grid(Mesh* mesh) : _mesh(mesh) {
+Grid::Grid(Mesh* mesh) : _mesh(mesh), _sharedValues(nullptr), _sharedParity(0), _minStep(0.0), _maxLevel(0), _frontierLevel(0) {
+    const auto& transferScheme = Config::getInstance()->getTransferScheme();
+    if (transferScheme == "explicit") {
+        _transferScheme = TransferScheme::EXPLICIT;
+    } else if (transferScheme == "implicit") {
+        _transferScheme = TransferScheme::IMPLICIT;
+    } else {
+        throw std::runtime_error("unknown transfer scheme: " + transferScheme);
+    }
+
+    build({});
+    buildSyncPlan();
+
+    // get size of grid for each node
+    std::ostringstream os;
+    os << "Grid creation: ";
+
+    int normalSize = 0, borderSize = 0, parallelSize = 0;
+    for (const auto& cell : _cells) {
+        switch (cell->getType()) {
+            case BaseCell::Type::NORMAL:
+                normalSize++;
+                break;
+            case BaseCell::Type::BORDER:
+                borderSize++;
+                break;
+            case BaseCell::Type::PARALLEL:
+                parallelSize++;
+                break;
+        }
+    }
+
+    os << "[Rank " << Parallel::getRank() << "]"
+       << "[" << Parallel::getName() << "] "
+       << "all = " << _cells.size()
+       << "; normal = " << normalSize
+       << "; border = " << borderSize
+       << "; parallel = " << parallelSize;
+    std::string message = os.str();
+
+    auto messages = Parallel::gather(message, 0);
+    if (Parallel::isMaster()) {
+        for (const auto& otherMessage : messages) {
+            std::cout << otherMessage << std::endl;
+        }
+    }
+}
+
+void Grid::build(const std::map<int, std::shared_ptr<BaseCell>>& retainedCells) {
     auto config = Config::getInstance();
     const auto& initialParameters = config->getInitialParameters();
     const auto& boundaryParameters = config->getBoundaryParameters();
 
+    _cells.clear();
+    _cellIndexes.assign(static_cast<std::size_t>(_mesh->getElementsSize()), -1);
+    _parallelCellIndexes.assign(static_cast<std::size_t>(_mesh->getElementsSize()), -1);
+    _normalCells.clear();
+    _borderCells.clear();
+    _parallelCells.clear();
+    _connections.clear();
+
     // create normal cell for "Main" elements for current process
-    for (const auto& element : _mesh->getElements()) {
-        if (element->isMain() == true) {
-            if (Parallel::isSingle() == false && element->getProcessId() != Parallel::getRank()) {
+    for (int ei = 0; ei < _mesh->getElementsSize(); ei++) {
+        if (_mesh->isMain(ei) == true) {
+            if (Parallel::isSingle() == false && _mesh->getProcessId(ei) != Parallel::getRank()) {
+                continue;
+            }
+
+            // keep already computed cell, only its connections are recreated
+            auto retainedCell = retainedCells.find(_mesh->getElementId(ei));
+            if (retainedCell != retainedCells.end()) {
+                addCell(retainedCell->second);
                 continue;
             }
 
             // create normal cell
-            double volume = element->getVolume();
-            normalizeVolume(element.get(), volume);
-            auto cell = new NormalCell(element->getId(), volume);
+            double volume = _mesh->getVolume(ei);
+            normalizeVolume(_mesh->getElementType(ei), volume);
+            auto cell = new NormalCell(_mesh->getElementId(ei), volume);
             addCell(cell);
 
             // set initial params by physical group
             for (const auto& param : initialParameters) {
-                if (param.getGroup() == element->getGroup()) {
+                if (param.getGroup() == _mesh->getGroup(ei)) {
                     for (auto i = 0; i < param.getPressure().size(); i++) {
                         cell->getParams().setPressure(i, param.getPressure(i));
                     }
@@ -58,51 +126,49 @@ Grid::Grid(Mesh* mesh) : _mesh(mesh) {
 
     // create cell connections
     for (const auto& cell : cells) {
-        auto element = _mesh->getElement(cell->getId());
-        for (const auto& sideElement : element->getSideElements()) {
-            auto neighborElement = _mesh->getElement(sideElement->getNeighborId());
+        auto ei = _mesh->getElementIndex(cell->getId());
+        for (int si = _mesh->getSidesBegin(ei); si < _mesh->getSidesEnd(ei); si++) {
+            auto neighborId = _mesh->getSideNeighborId(si);
+            auto neighbor = _mesh->getElementIndex(neighborId);
 
-            if (neighborElement->isMain()) {
-                if (Parallel::isSingle() || neighborElement->getProcessId() == Parallel::getRank()) {
+            if (_mesh->isMain(neighbor)) {
+                if (Parallel::isSingle() || _mesh->getProcessId(neighbor) == Parallel::getRank()) {
 
                     // get square
-                    double square = sideElement->getElement()->getVolume();
-                    normalizeVolume(sideElement->getElement().get(), square);
+                    double square = _mesh->getSideVolume(si);
+                    normalizeVolume(_mesh->getSideType(si), square);
 
                     // create connection for cell with other normal cell
-                    auto neighborCell = getCellById(neighborElement->getId());
-                    auto connection = new CellConnection(cell, neighborCell, square, sideElement->getNormal());
-                    cell->addConnection(connection);
+                    auto neighborCell = getCellById(neighborId);
+                    _connections.add(cell->getIndex(), neighborCell->getIndex(), square, _mesh->getSideNormal(si));
                 } else {
 
                     // create or get parallel cell
-                    BaseCell* parallelCell = getCellById(-neighborElement->getId());
+                    BaseCell* parallelCell = getCellById(-neighborId);
                     if (parallelCell == nullptr) {
-                        parallelCell = new ParallelCell(-neighborElement->getId(), neighborElement->getId(), neighborElement->getProcessId());
+                        parallelCell = new ParallelCell(-neighborId, neighborId, _mesh->getProcessId(neighbor));
                         addCell(parallelCell);
                     }
 
                     // get square
-                    double square = sideElement->getElement()->getVolume();
-                    normalizeVolume(sideElement->getElement().get(), square);
+                    double square = _mesh->getSideVolume(si);
+                    normalizeVolume(_mesh->getSideType(si), square);
 
                     // create connection for parallel cell
-                    auto parallelConnection = new CellConnection(parallelCell, cell, square, -sideElement->getNormal());
-                    parallelCell->addConnection(parallelConnection);
+                    _connections.add(parallelCell->getIndex(), cell->getIndex(), square, -_mesh->getSideNormal(si));
 
                     // create connection for cell
-                    auto connection = new CellConnection(cell, parallelCell, square, sideElement->getNormal());
-                    cell->addConnection(connection);
+                    _connections.add(cell->getIndex(), parallelCell->getIndex(), square, _mesh->getSideNormal(si));
                 }
-            } else if (neighborElement->isBorder()) {
+            } else if (_mesh->isBorder(neighbor)) {
 
                 // create border cell
-                auto borderCell = new BorderCell(neighborElement->getId());
+                auto borderCell = new BorderCell(neighborId);
                 addCell(borderCell);
 
                 // set boundary params by physical group
                 for (const auto& param : boundaryParameters) {
-                    if (param.getGroup() == neighborElement->getGroup()) {
+                    if (param.getGroup() == _mesh->getGroup(neighbor)) {
                         for (auto i = 0; i < param.getType().size(); i++) {
                             BorderCell::BorderType borderType;
                             auto type = param.getType()[i];
@@ -128,58 +194,29 @@ Grid::Grid(Mesh* mesh) : _mesh(mesh) {
                 }
 
                 // get square
-                double square = sideElement->getElement()->getVolume();
-                normalizeVolume(sideElement->getElement().get(), square);
+                double square = _mesh->getSideVolume(si);
+                normalizeVolume(_mesh->getSideType(si), square);
 
                 // create connection for border cell
-                auto borderConnection = new CellConnection(borderCell, cell, square, -sideElement->getNormal());
-                borderCell->addConnection(borderConnection);
+                _connections.add(borderCell->getIndex(), cell->getIndex(), square, -_mesh->getSideNormal(si));
 
                 // create connection for cell
-                auto connection = new CellConnection(cell, borderCell, square, sideElement->getNormal());
-                cell->addConnection(connection);
+                _connections.add(cell->getIndex(), borderCell->getIndex(), square, _mesh->getSideNormal(si));
             } else {
                 throw std::runtime_error("wrong neighbor element");
             }
         }
     }
 
-    // get size of grid for each node
-    std::ostringstream os;
-    os << "Grid creation: ";
-
-    int normalSize = 0, borderSize = 0, parallelSize = 0;
+    // connections of all cells (with border and parallel cells) are grouped by cell index
+    cells.clear();
     for (const auto& cell : _cells) {
-        switch (cell->getType()) {
-            case BaseCell::Type::NORMAL:
-                normalSize++;
-                break;
-            case BaseCell::Type::BORDER:
-                borderSize++;
-                break;
-            case BaseCell::Type::PARALLEL:
-                parallelSize++;
-                break;
-        }
+        cells.push_back(cell.get());
     }
+    _connections.build(std::move(cells));
 
-    os << "[Rank " << Parallel::getRank() << "]"
-       << "[" << Parallel::getName() << "] "
-       << "all = " << _cells.size()
-       << "; normal = " << normalSize
-       << "; border = " << borderSize
-       << "; parallel = " << parallelSize;
-    std::string message = os.str();
-
-    if (Parallel::isMaster()) {
-        std::cout << message << std::endl;
-
-        for (int rank = 1; rank < Parallel::getSize(); rank++) {
-            message = Parallel::recv(rank, Parallel::COMMAND_MESSAGE);
-            std::cout << message << std::endl;
-        }
-    } else {
-        Parallel::send(message, 0, Parallel::COMMAND_MESSAGE);
+    if (_transferScheme == TransferScheme::IMPLICIT) {
+        buildSweeps();
     }
 }
 
@@ -187,20 +224,42 @@ void Grid::init() {
     for (const auto& cell : _cells) {
         cell->init();
     }
+    initTimestep();
+}
 
-    double minStep = std::numeric_limits<double>::max();
+void Grid::restore(std::map<int, std::vector<std::vector<double>>>& valuesMap) {
+
+    // normal cells take saved values, others are initialized as usual
     for (const auto& cell : _cells) {
         if (cell->getType() == BaseCell::Type::NORMAL) {
-            auto normalCell = dynamic_cast<NormalCell*>(cell.get());
-
-            double maxSquare = 0.0;
-            for (const auto& connection : normalCell->getConnections()) {
-                maxSquare = std::max(connection->getSquare(), maxSquare);
+            auto pos = valuesMap.find(cell->getId());
+            if (pos == valuesMap.end()) {
+                throw std::runtime_error("no saved values for cell " + std::to_string(cell->getId()));
             }
-            double step = normalCell->getVolume() / maxSquare;
-            minStep = std::min(minStep, step);
+            dynamic_cast<NormalCell*>(cell.get())->restore(std::move(pos->second));
+        } else {
+            cell->init();
         }
     }
+    initTimestep();
+}
+
+void Grid::initTimestep() {
+    double minStep = std::numeric_limits<double>::max();
+    for (const auto& cell : _normalCells) {
+        minStep = std::min(minStep, getStep(_mesh->getElementIndex(cell->getId())));
+    }
+
+    // levels of cells are counted from smallest step of whole grid
+    if (Parallel::isSingle() == false) {
+        minStep = Parallel::allreduce(minStep, Parallel::Operation::MIN);
+    }
+    _minStep = minStep;
+    _maxLevel = initLevels();
+    if (Parallel::isSingle() == false) {
+        _maxLevel = Parallel::allreduce(_maxLevel, Parallel::Operation::MAX);
+    }
+    initFrontierLevel();
 
     auto config = Config::getInstance();
 
@@ -209,30 +268,16 @@ void Grid::init() {
         minMass = std::min(minMass, gas.getMass());
     }
 
-    double timestep = 0.95 * 2 * minStep * minMass / config->getImpulseSphere()->getMaxImpulse();
-
-    if (Parallel::isSingle() == false) {
-        if (Parallel::isMaster() == true) {
-            for (auto rank = 1; rank < Parallel::getSize(); rank++) {
-                double otherTimestep = 0.0;
-                SerializationUtils::deserialize(Parallel::recv(rank, Parallel::COMMAND_TIMESTEP), otherTimestep);
-                timestep = std::min(timestep, otherTimestep);
-            }
-
-            for (auto rank = 1; rank < Parallel::getSize(); rank++) {
-                Parallel::send(SerializationUtils::serialize(timestep), rank, Parallel::COMMAND_TIMESTEP);
-            }
-        } else {
-            Parallel::send(SerializationUtils::serialize(timestep), 0, Parallel::COMMAND_TIMESTEP);
-            SerializationUtils::deserialize(Parallel::recv(0, Parallel::COMMAND_TIMESTEP), timestep);
-        }
-    }
+    // iteration takes 2^maxLevel smallest timesteps, implicit transfer isn't limited by courant number of 1
+    double timestep = config->getCourantNumber() * 2 * minStep * minMass / config->getImpulseSphere()->getMaxImpulse();
+    timestep *= 1 << _maxLevel;
 
     config->setTimestep(timestep);
 
     if (Parallel::isMaster()) {
         std::cout << "MinMass = " << minMass << std::endl;
         std::cout << "MinStep = " << minStep << std::endl;
+        std::cout << "MaxLevel = " << _maxLevel << std::endl;
         std::cout << "Timestep = " << timestep << std::endl;
 
         config->getNormalizer()->restore(timestep, Normalizer::Type::TIME);
@@ -240,16 +285,80 @@ void Grid::init() {
     }
 }
 
+int Grid::initLevels() {
+    auto maxTimeLevel = static_cast<int>(Config::getInstance()->getMaxTimeLevel());
+    if (_transferScheme == TransferScheme::IMPLICIT) {
+        maxTimeLevel = 0;
+    }
+
+    // step of parallel cell is found by its halo element, so processes agree on levels of their sides
+    int maxLevel = 0;
+    for (const auto& cell : _cells) {
+        if (cell->getType() != BaseCell::Type::BORDER) {
+            double step = getStep(_mesh->getElementIndex(std::abs(cell->getId())));
+            int level = 0;
+            while (level < maxTimeLevel && _minStep * (2 << level) <= step) {
+                level++;
+            }
+            cell->setLevel(level);
+            maxLevel = std::max(maxLevel, level);
+        }
+    }
+
+    // border cell is updated with its normal cell
+    for (const auto& cell : _borderCells) {
+        cell->setLevel(_connections.getNeighbor(_connections.getBegin(cell->getIndex()))->getLevel());
+    }
+    return maxLevel;
+}
+
+void Grid::initFrontierLevel() {
+
+    // frontier cells of both sides are parallel cells and their neighbors
+    int frontierLevel = _maxLevel;
+    for (const auto& cell : _parallelCells) {
+        frontierLevel = std::min(frontierLevel, cell->getLevel());
+        for (int ci = _connections.getBegin(cell->getIndex()); ci < _connections.getEnd(cell->getIndex()); ci++) {
+            frontierLevel = std::min(frontierLevel, _connections.getNeighbor(ci)->getLevel());
+        }
+    }
+    if (Parallel::isSingle() == false) {
+        frontierLevel = Parallel::allreduce(frontierLevel, Parallel::Operation::MIN);
+    }
+    _frontierLevel = frontierLevel;
+}
+
+double Grid::getStep(int ei) {
+    double volume = _mesh->getVolume(ei);
+    normalizeVolume(_mesh->getElementType(ei), volume);
+
+    double maxSquare = 0.0;
+    for (int si = _mesh->getSidesBegin(ei); si < _mesh->getSidesEnd(ei); si++) {
+        double square = _mesh->getSideVolume(si);
+        normalizeVolume(_mesh->getSideType(si), square);
+        maxSquare = std::max(square, maxSquare);
+    }
+    return volume / maxSquare;
+}
+
 void Grid::computeTransfer() {
+    if (_transferScheme == TransferScheme::IMPLICIT) {
+        computeImplicitTransfer();
+        return;
+    }
+    if (_maxLevel > 0) {
+        computeLocalTransfer();
+        return;
+    }
 
     // first go for border cells
     for (const auto& cell : _borderCells) {
-        cell->computeTransfer();
+        cell->computeTransfer(_connections);
     }
 
     // then go for normal cells
     for (const auto& cell : _normalCells) {
-        cell->computeTransfer();
+        cell->computeTransfer(_connections);
     }
 
     // move changes from next step to current step
@@ -258,6 +367,74 @@ void Grid::computeTransfer() {
     }
 }
 
+void Grid::computeLocalTransfer() {
+    int stepsSize = 1 << _maxLevel;
+    double timestep = Config::getInstance()->getTimestep() / 2 / stepsSize;
+
+    for (int step = 0; step < stepsSize; step++) {
+
+        // values of neighbor processes are changed only when their frontier cells are updated
+        if (step > 0 && step % (1 << _frontierLevel) == 0 && Parallel::isSingle() == false) {
+            sync();
+        }
+
+        // border cells go first at rate of their normal cells
+        for (const auto& cell : _borderCells) {
+            if (step % (1 << cell->getLevel()) == 0) {
+                cell->computeTransfer(_connections);
+            }
+        }
+
+        // fluxes are gathered by all cells, then cells which end their step take them
+        for (const auto& cell : _normalCells) {
+            cell->computeLocalTransfer(_connections, step, timestep);
+        }
+        for (const auto& cell : _normalCells) {
+            if ((step + 1) % (1 << cell->getLevel()) == 0) {
+                cell->applyLocalTransfer();
+            }
+        }
+    }
+}
+
+void Grid::computeImplicitTransfer() {
+    for (const auto& cell : _normalCells) {
+        cell->startImplicitTransfer();
+    }
+
+    // gauss-seidel sweeps: each group of impulses goes downstream through cells, so one sweep
+    // passes them through whole grid, values of neighbor processes are taken from last sweep
+    auto sweeps = Config::getInstance()->getTransferSweeps();
+    for (unsigned int sweep = 0; sweep < sweeps; sweep++) {
+        if (sweep > 0 && Parallel::isSingle() == false) {
+            sync();
+        }
+
+        for (const auto& cell : _borderCells) {
+            cell->computeTransfer(_connections);
+        }
+        for (std::size_t group = 0; group < _sweepCells.size(); group++) {
+            for (const auto& cell : _sweepCells[group]) {
+                cell->computeImplicitTransfer(_connections, _sweepImpulses[group]);
+            }
+        }
+    }
+
+    // sweeps are stopped before exact solution, so fluxes are taken once more from solved values
+    if (Parallel::isSingle() == false) {
+        sync();
+    }
+    for (const auto& cell : _borderCells) {
+        cell->computeTransfer(_connections);
+    }
+    for (const auto& cell : _normalCells) {
+        cell->finishImplicitTransfer(_connections);
+    }
+    for (const auto& cell : _normalCells) {
+        cell->swapValues();
+    }
+}
+
 void Grid::computeIntegral(unsigned int gi1, unsigned int gi2) {
     auto impulse = Config::getInstance()->getImpulseSphere();
     const auto& gases = Config::getInstance()->getGases();
@@ -270,21 +447,42 @@ void Grid::computeIntegral(unsigned int gi1, unsigned int gi2) {
     particle1.d = gases[gi1].getRadius();
     particle2.d = gases[gi2].getRadius();
 
-    ci::gen(timestep, 50000,
-            impulse->getResolution() / 2, impulse->getResolution() / 2,
-            impulse->getXYZ2I(), impulse->getXYZ2I(),
-            impulse->getDeltaImpulse(),
-            gases[gi1].getMass(), gases[gi2].getMass(),
-            particle1, particle2);
+    // with local time stepping cells of each level take collisions 2^(maxLevel - level) times with their own timestep
+    for (int level = 0; level <= _maxLevel; level++) {
+        std::vector<NormalCell*> cells;
+        for (const auto& cell : _normalCells) {
+            if (cell->getLevel() == level) {
+                cells.push_back(cell);
+            }
+        }
+        if (cells.empty() == true) {
+            continue;
+        }
 
-    for (const auto& cell : _normalCells) {
-        cell->computeIntegral(gi1, gi2);
+        int stepsSize = 1 << (_maxLevel - level);
+        ci::gen(timestep / stepsSize, 50000,
+                impulse->getResolution() / 2, impulse->getResolution() / 2,
+                impulse->getXYZ2I(), impulse->getXYZ2I(),
+                impulse->getDeltaImpulse(),
+                gases[gi1].getMass(), gases[gi2].getMass(),
+                particle1, particle2);
+
+        for (int step = 0; step < stepsSize; step++) {
+            for (const auto& cell : cells) {
+                cell->computeIntegral(gi1, gi2);
+            }
+        }
     }
 }
 
 void Grid::computeBetaDecay(unsigned int gi0, unsigned int gi1, double lambda) {
+
+    // decay of cell is split into steps of its level like collisions
     for (const auto& cell : _normalCells) {
-        cell->computeBetaDecay(gi0, gi1, lambda);
+        int stepsSize = 1 << (_maxLevel - cell->getLevel());
+        for (int step = 0; step < stepsSize; step++) {
+            cell->computeBetaDecay(gi0, gi1, lambda / stepsSize);
+        }
     }
 }
 
@@ -295,24 +493,228 @@ void Grid::check() {
 }
 
 void Grid::sync() {
-    std::map<int, std::vector<int>> sendSyncIdsMap;
-    std::map<int, std::vector<int>> recvSyncIdsMap;
+    auto config = Config::getInstance();
+    auto precision = config->getTransportPrecision();
+    auto cellSize = config->getGases().size() * config->getImpulseSphere()->getImpulses().size();
+
+    // processes on the same node exchange values through shared memory
+    if (Parallel::isSingle() == false && config->isUsingSharedMemory() == true) {
+        for (const auto& pair : _sharedSendOffsetsMap) {
+            const auto& sendSyncIndexes = _sendSyncIndexesMap[pair.first];
+            double* position = _sharedValues + pair.second + _sharedParity * sendSyncIndexes.size() * cellSize;
+            for (auto sendSyncIndex : sendSyncIndexes) {
+                for (const auto& values : _cells[sendSyncIndex]->getValues()) {
+                    std::copy(values.begin(), values.end(), position);
+                    position += values.size();
+                }
+            }
+        }
+        Parallel::syncShared();
+        for (const auto& pair : _sharedRecvValuesMap) {
+            const auto& recvSyncIndexes = _recvSyncIndexesMap[pair.first];
+            const double* position = pair.second + _sharedParity * recvSyncIndexes.size() * cellSize;
+            for (auto recvSyncIndex : recvSyncIndexes) {
+                for (auto& values : _cells[recvSyncIndex]->getValues()) {
+                    std::copy(position, position + values.size(), values.begin());
+                    position += values.size();
+                }
+            }
+        }
+        _sharedParity = 1 - _sharedParity;
+    }
 
-    // fill map
+    // one message with values of all frontier cells for each neighbor process on other nodes
+    for (auto rank = 0; rank < Parallel::getSize(); rank++) {
+        if (rank == Parallel::getRank()) {
+            // recv
+            for (auto otherRank = 0; otherRank < Parallel::getSize(); otherRank++) {
+                if (otherRank != rank && _sharedRecvValuesMap.count(otherRank) == 0) {
+                    if (_recvSyncIndexesMap.count(otherRank) != 0) {
+                        std::string buffer = Parallel::recv(otherRank, Parallel::COMMAND_SYNC_VALUES);
+                        const char* position = buffer.data();
+                        for (auto recvSyncIndex : _recvSyncIndexesMap[otherRank]) {
+                            const auto& cell = _cells[recvSyncIndex];
+                            for (auto& values : cell->getValues()) {
+                                position = PrecisionUtils::unpack(position, precision, values.data(), values.size());
+                            }
+                        }
+                    }
+                }
+            }
+        } else if (_sharedSendOffsetsMap.count(rank) == 0) {
+            // send to rank process
+            if (_sendSyncIndexesMap.count(rank) != 0) {
+                std::string buffer;
+                for (auto sendSyncIndex : _sendSyncIndexesMap[rank]) {
+                    const auto& cell = _cells[sendSyncIndex];
+                    for (const auto& values : cell->getValues()) {
+                        PrecisionUtils::pack(values.data(), values.size(), precision, buffer);
+                    }
+                }
+                Parallel::send(buffer, rank, Parallel::COMMAND_SYNC_VALUES);
+            }
+        }
+    }
+}
+
+int Grid::rebalance(const std::vector<double>& workTimes) {
+    int rank = Parallel::getRank();
+
+    // collect frontier cells for each neighbor process
+    std::map<int, std::vector<int>> frontierIdsMap;
     for (const auto& cell : _parallelCells) {
+        auto& frontierIds = frontierIdsMap[cell->getSyncProcessId()];
+        const auto& sendSyncIds = cell->getSendSyncIds(_connections);
+        frontierIds.insert(frontierIds.end(), sendSyncIds.begin(), sendSyncIds.end());
+    }
+    for (auto& pair : frontierIdsMap) {
+        std::vector<int>& frontierIds = pair.second;
+        std::sort(frontierIds.begin(), frontierIds.end());
+        frontierIds.erase(std::unique(frontierIds.begin(), frontierIds.end()), frontierIds.end());
+    }
 
-        // create vectors for data
-        auto syncProcessId = cell->getSyncProcessId();
-        if (sendSyncIdsMap.count(syncProcessId) == 0) {
-            sendSyncIdsMap[syncProcessId] = std::vector<int>();
+    // diffusion scheme: give each lighter neighbor a share of the work difference,
+    // only the frontier layer is moved at once, so big differences take several steps
+    std::vector<int> moves;
+    if (_normalCells.empty() == false) {
+        double cellTime = workTimes[rank] / _normalCells.size();
+        auto leftSize = _normalCells.size();
+        std::set<int> movedIds;
+        for (const auto& pair : frontierIdsMap) {
+            auto otherRank = pair.first;
+            if (workTimes[otherRank] >= workTimes[rank] || cellTime <= 0.0) {
+                continue;
+            }
+
+            double excessTime = (workTimes[rank] - workTimes[otherRank]) / (frontierIdsMap.size() + 1);
+            auto count = static_cast<std::size_t>(excessTime / cellTime);
+            for (auto id : pair.second) {
+                if (count == 0 || leftSize <= 1) {
+                    break;
+                }
+                if (movedIds.insert(id).second) {
+                    moves.push_back(id);
+                    moves.push_back(otherRank);
+                    count--;
+                    leftSize--;
+                }
+            }
         }
-        if (recvSyncIdsMap.count(syncProcessId) == 0) {
-            recvSyncIdsMap[syncProcessId] = std::vector<int>();
+    }
+
+    // share all moves (pairs of cell id and new process id) with every process
+    auto movesBuffers = Parallel::allgather(SerializationUtils::serialize(moves));
+    moves.clear();
+    for (const auto& movesBuffer : movesBuffers) {
+        std::vector<int> otherMoves;
+        SerializationUtils::deserialize(movesBuffer, otherMoves);
+        moves.insert(moves.end(), otherMoves.begin(), otherMoves.end());
+    }
+
+    if (moves.empty()) {
+        return 0;
+    }
+
+    // change owners of elements, process knows only elements of its submesh
+    std::map<int, std::vector<int>> sendIdsMap;
+    std::map<int, std::vector<int>> recvIdsMap;
+    for (std::size_t i = 0; i < moves.size(); i += 2) {
+        auto ei = _mesh->getElementIndex(moves[i]);
+        if (ei == -1) {
+            continue;
         }
+        auto oldRank = _mesh->getProcessId(ei);
+        auto newRank = moves[i + 1];
+        if (oldRank == rank) {
+            sendIdsMap[newRank].push_back(moves[i]);
+        } else if (newRank == rank) {
+            recvIdsMap[oldRank].push_back(moves[i]);
+        }
+        _mesh->setProcessId(ei, newRank);
+    }
+
+    // move elements with their neighbors and values of cells to new owners
+    std::vector<std::string> meshBuffers(static_cast<std::size_t>(Parallel::getSize()));
+    std::vector<std::string> valuesBuffers(static_cast<std::size_t>(Parallel::getSize()));
+    for (const auto& pair : sendIdsMap) {
+        Mesh* submesh = _mesh->createSubmesh(pair.second);
+        meshBuffers[pair.first] = SerializationUtils::serialize(submesh);
+        delete submesh;
+
+        std::vector<std::vector<std::vector<double>>> values;
+        for (auto id : pair.second) {
+            values.push_back(getCellById(id)->getValues());
+        }
+        valuesBuffers[pair.first] = SerializationUtils::serialize(values);
+    }
+    meshBuffers = Parallel::alltoall(meshBuffers);
+    valuesBuffers = Parallel::alltoall(valuesBuffers);
+
+    std::map<int, std::vector<std::vector<double>>> recvValuesMap;
+    for (const auto& pair : recvIdsMap) {
+        Mesh* submesh = nullptr;
+        SerializationUtils::deserialize(meshBuffers[pair.first], submesh);
+        submesh->resetMaps();
+        _mesh->merge(*submesh);
+        delete submesh;
+
+        std::vector<std::vector<std::vector<double>>> values;
+        SerializationUtils::deserialize(valuesBuffers[pair.first], values);
+        for (std::size_t i = 0; i < pair.second.size(); i++) {
+            recvValuesMap[pair.second[i]] = std::move(values[i]);
+        }
+    }
+
+    // rebuild grid around cells which stay on current process
+    std::map<int, std::shared_ptr<BaseCell>> retainedCells;
+    for (const auto& cell : _cells) {
+        if (cell->getType() == BaseCell::Type::NORMAL && _mesh->getProcessId(_mesh->getElementIndex(cell->getId())) == rank) {
+            retainedCells[cell->getId()] = cell;
+        }
+    }
+    build(retainedCells);
+    buildSyncPlan();
+    initLevels();
+    initFrontierLevel();
+
+    for (const auto& cell : _cells) {
+        if (retainedCells.count(cell->getId()) == 0) {
+            cell->init();
+        }
+    }
+    for (auto& pair : recvValuesMap) {
+        getCellById(pair.first)->getValues() = std::move(pair.second);
+    }
+
+    return static_cast<int>(moves.size() / 2);
+}
+
+BaseCell* Grid::getCellById(int id) const {
+    auto ei = _mesh->getElementIndex(std::abs(id));
+    if (ei == -1 || static_cast<std::size_t>(ei) >= _cellIndexes.size()) {
+        return nullptr;
+    }
+    auto index = id < 0 ? _parallelCellIndexes[ei] : _cellIndexes[ei];
+    return index != -1 ? _cells[index].get() : nullptr;
+}
+
+void Grid::addCell(BaseCell* cell) {
+    if (getCellById(cell->getId()) == nullptr) {
+        addCell(std::shared_ptr<BaseCell>(cell));
+    }
+}
+
+void Grid::buildSyncPlan() {
+    std::map<int, std::vector<int>> sendSyncIdsMap;
+    std::map<int, std::vector<int>> recvSyncIdsMap;
+
+    // fill map
+    for (const auto& cell : _parallelCells) {
 
         // add send elements
+        auto syncProcessId = cell->getSyncProcessId();
         auto& sendSyncIds = sendSyncIdsMap[syncProcessId];
-        const auto& cellSendSyncIds = cell->getSendSyncIds();
+        const auto& cellSendSyncIds = cell->getSendSyncIds(_connections);
         sendSyncIds.insert(sendSyncIds.end(), cellSendSyncIds.begin(), cellSendSyncIds.end());
 
         // add recv element
@@ -320,88 +722,150 @@ void Grid::sync() {
         recvSyncIds.insert(recvSyncIds.end(), cell->getRecvSyncId());
     }
 
-    // sort all
-    for (const auto& pair : sendSyncIdsMap) {
-        std::vector<int>& sendSyncIds = sendSyncIdsMap.at(pair.first);
+    // sort all, both processes order frontier cells by element ids
+    for (auto& pair : sendSyncIdsMap) {
+        std::vector<int>& sendSyncIds = pair.second;
         std::sort(sendSyncIds.begin(), sendSyncIds.end());
         sendSyncIds.erase(std::unique(sendSyncIds.begin(), sendSyncIds.end()), sendSyncIds.end());
     }
-    for (const auto& pair : recvSyncIdsMap) {
-        std::vector<int>& recvSyncIds = recvSyncIdsMap.at(pair.first);
+    for (auto& pair : recvSyncIdsMap) {
+        std::vector<int>& recvSyncIds = pair.second;
         std::sort(recvSyncIds.begin(), recvSyncIds.end());
         recvSyncIds.erase(std::unique(recvSyncIds.begin(), recvSyncIds.end()), recvSyncIds.end());
     }
 
-//    for (const auto& pair : sendSyncIdsMap) {
-//        std::cout << "Send to process: " << pair.first << std::endl;
-//        for (const auto& sendSyncId : pair.second) {
-//            std::cout << sendSyncId << " ";
-//        }
-//        std::cout << std::endl;
-//    }
-//
-//    for (const auto& pair : recvSyncIdsMap) {
-//        std::cout << "Recv from process: " << pair.first << std::endl;
-//        for (const auto& recvSyncId : pair.second) {
-//            std::cout << recvSyncId << " ";
-//        }
-//        std::cout << std::endl;
-//    }
-
-    // send and recv
-    for (auto rank = 0; rank < Parallel::getSize(); rank++) {
-        if (rank == Parallel::getRank()) {
-            // recv
-            for (auto otherRank = 0; otherRank < Parallel::getSize(); otherRank++) {
-                if (otherRank != rank) {
-                    if (recvSyncIdsMap.count(otherRank) != 0) {
-                        const auto& recvSyncIds = recvSyncIdsMap[otherRank];
-                        for (auto recvSyncId : recvSyncIds) {
-                            auto cell = getCellById(-recvSyncId);
-                            SerializationUtils::deserialize(Parallel::recv(otherRank, Parallel::COMMAND_SYNC_VALUES), cell->getValues());
-                        }
-                    }
-                }
-            }
-        } else {
-            // send to rank process
-            if (sendSyncIdsMap.count(rank) != 0) {
-                const auto& sendSyncIds = sendSyncIdsMap[rank];
-                for (auto sendSyncId : sendSyncIds) {
-                    auto cell = getCellById(sendSyncId);
-                    Parallel::send(SerializationUtils::serialize(cell->getValues()), rank, Parallel::COMMAND_SYNC_VALUES);
-                }
-            }
+    // sync goes through cell indexes only
+    _sendSyncIndexesMap.clear();
+    _recvSyncIndexesMap.clear();
+    for (const auto& pair : sendSyncIdsMap) {
+        auto& sendSyncIndexes = _sendSyncIndexesMap[pair.first];
+        for (auto sendSyncId : pair.second) {
+            sendSyncIndexes.push_back(getCellById(sendSyncId)->getIndex());
+        }
+    }
+    for (const auto& pair : recvSyncIdsMap) {
+        auto& recvSyncIndexes = _recvSyncIndexesMap[pair.first];
+        for (auto recvSyncId : pair.second) {
+            recvSyncIndexes.push_back(getCellById(-recvSyncId)->getIndex());
         }
     }
+
+    if (Parallel::isSingle() == false && Config::getInstance()->isUsingSharedMemory() == true) {
+        buildSharedPlan();
+    }
 }
 
-void Grid::addCell(BaseCell* cell) {
-    if (_cellsMap[cell->getId()] == nullptr) {
-        _cellsMap[cell->getId()] = cell;
-        _cells.emplace_back(cell);
+void Grid::buildSharedPlan() {
+    auto config = Config::getInstance();
+    auto cellSize = config->getGases().size() * config->getImpulseSphere()->getImpulses().size();
+
+    // own segment keeps two blocks (one per parity) for each neighbor process on the same node
+    _sharedSendOffsetsMap.clear();
+    std::size_t sharedSize = 0;
+    std::vector<std::string> offsetBuffers(static_cast<std::size_t>(Parallel::getSize()));
+    for (const auto& pair : _sendSyncIndexesMap) {
+        if (Parallel::isSameNode(pair.first) == true && pair.first != Parallel::getRank()) {
+            _sharedSendOffsetsMap[pair.first] = sharedSize;
+            offsetBuffers[pair.first] = std::to_string(sharedSize);
+            sharedSize += 2 * pair.second.size() * cellSize;
+        }
+    }
+    _sharedValues = Parallel::allocateShared(sharedSize);
+
+    // neighbors tell where their blocks for this process are
+    _sharedRecvValuesMap.clear();
+    auto recvOffsetBuffers = Parallel::alltoall(offsetBuffers);
+    for (const auto& pair : _recvSyncIndexesMap) {
+        if (recvOffsetBuffers[pair.first].empty() == false) {
+            auto offset = std::stoul(recvOffsetBuffers[pair.first]);
+            _sharedRecvValuesMap[pair.first] = Parallel::getShared(pair.first) + offset;
+        }
+    }
+    _sharedParity = 0;
+}
+
+void Grid::buildSweeps() {
+    const auto& impulses = Config::getInstance()->getImpulseSphere()->getImpulses();
+
+    // impulses are grouped by octant and by their biggest coordinate, so directions of group are close
+    std::vector<std::vector<int>> groups(24);
+    std::vector<Vector3d> directions(24);
+    for (int ii = 0; ii < static_cast<int>(impulses.size()); ii++) {
+        const auto& impulse = impulses[ii];
+        int octant = (impulse.x() < 0 ? 1 : 0) | (impulse.y() < 0 ? 2 : 0) | (impulse.z() < 0 ? 4 : 0);
+        double x = std::abs(impulse.x()), y = std::abs(impulse.y()), z = std::abs(impulse.z());
+        int axis = x >= y && x >= z ? 0 : (y >= z ? 1 : 2);
+        groups[octant * 3 + axis].push_back(ii);
+        directions[octant * 3 + axis] += impulse;
+    }
+
+    std::vector<Vector3d> centers;
+    for (const auto& cell : _normalCells) {
+        auto ei = _mesh->getElementIndex(cell->getId());
+        Vector3d center;
+        for (auto node : _mesh->getElementNodes(ei)) {
+            center += _mesh->getNodePosition(node);
+        }
+        centers.push_back(center / _mesh->getElementNodes(ei).size());
+    }
+
+    // cells of group are sorted by projections of their centers onto mean direction of group
+    _sweepImpulses.clear();
+    _sweepCells.clear();
+    for (std::size_t group = 0; group < groups.size(); group++) {
+        if (groups[group].empty() == true) {
+            continue;
+        }
+
+        const auto& direction = directions[group];
+        std::vector<double> projections;
+        for (const auto& center : centers) {
+            projections.push_back(center.x() * direction.x() + center.y() * direction.y() + center.z() * direction.z());
+        }
+
+        std::vector<int> order(_normalCells.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&projections](int left, int right) {
+            return projections[left] < projections[right];
+        });
+
+        _sweepImpulses.push_back(std::move(groups[group]));
+        _sweepCells.emplace_back();
+        for (auto i : order) {
+            _sweepCells.back().push_back(_normalCells[i]);
+        }
+    }
+}
+
+void Grid::addCell(const std::shared_ptr<BaseCell>& cell) {
+    if (getCellById(cell->getId()) == nullptr) {
+        auto ei = _mesh->getElementIndex(std::abs(cell->getId()));
+        auto& indexes = cell->getId() < 0 ? _parallelCellIndexes : _cellIndexes;
+        indexes[ei] = static_cast<int>(_cells.size());
+        cell->setIndex(static_cast<int>(_cells.size()));
+        _cells.push_back(cell);
 
         switch (cell->getType()) {
             case BaseCell::Type::NORMAL:
-                _normalCells.push_back(dynamic_cast<NormalCell*>(cell));
+                _normalCells.push_back(dynamic_cast<NormalCell*>(cell.get()));
                 break;
             case BaseCell::Type::BORDER:
-                _borderCells.push_back(dynamic_cast<BorderCell*>(cell));
+                _borderCells.push_back(dynamic_cast<BorderCell*>(cell.get()));
                 break;
             case BaseCell::Type::PARALLEL:
-                _parallelCells.push_back(dynamic_cast<ParallelCell*>(cell));
+                _parallelCells.push_back(dynamic_cast<ParallelCell*>(cell.get()));
                 break;
         }
     }
 }
 
-void Grid::normalizeVolume(Element* element, double& volume) {
+void Grid::normalizeVolume(Element::Type type, double& volume) {
     auto normalizer = Config::getInstance()->getNormalizer();
-    if (element->is1D()) {
+    if (Element::is1D(type)) {
         normalizer->normalize(volume, Normalizer::Type::LENGTH);
-    } else if (element->is2D()) {
+    } else if (Element::is2D(type)) {
         normalizer->normalize(volume, Normalizer::Type::SQUARE);
-    } else if (element->is3D()) {
+    } else if (Element::is3D(type)) {
         normalizer->normalize(volume, Normalizer::Type::VOLUME);
     }
 }
@@ -2,32 +2,69 @@
 #define RGS_GRID_H
 
 #include "utilities/Types.h"
+#include "mesh/Element.h"
+#include "CellConnections.h"
 
 #include <vector>
 #include <map>
+#include <memory>
 
 class BaseCell;
 class NormalCell;
 class BorderCell;
 class ParallelCell;
-class CellConnection;
 class Mesh;
-class Element;
 
 class Grid {
+public:
+    enum class TransferScheme {
+        EXPLICIT,
+        IMPLICIT
+    };
+
 private:
     Mesh* _mesh;
     std::vector<std::shared_ptr<BaseCell>> _cells;
-    std::map<int, BaseCell*> _cellsMap;
     std::vector<NormalCell*> _normalCells;
     std::vector<BorderCell*> _borderCells;
     std::vector<ParallelCell*> _parallelCells;
+    CellConnections _connections;
+
+    // cell indexes by element indexes of mesh, parallel cells (with negative ids) are kept apart,
+    // used by getCellById while grid is built and rebalanced, results are written and probes are located
+    std::vector<int> _cellIndexes;
+    std::vector<int> _parallelCellIndexes;
+
+    // indexes of cells to send and recv for each neighbor process, ordered by cell ids
+    std::map<int, std::vector<int>> _sendSyncIndexesMap;
+    std::map<int, std::vector<int>> _recvSyncIndexesMap;
+
+    // frontier values of processes on the same node, double buffered in shared memory
+    double* _sharedValues;
+    std::map<int, std::size_t> _sharedSendOffsetsMap;
+    std::map<int, const double*> _sharedRecvValuesMap;
+    std::size_t _sharedParity;
+
+    TransferScheme _transferScheme;
+
+    // implicit transfer: groups of impulses of close directions and normal cells ordered along each group
+    std::vector<std::vector<int>> _sweepImpulses;
+    std::vector<std::vector<NormalCell*>> _sweepCells;
+
+    // local time stepping: smallest step of cells and number of levels above smallest timestep
+    double _minStep;
+    int _maxLevel;
+
+    // smallest level of frontier cells of all processes, they are synced only after its steps
+    int _frontierLevel;
 
 public:
     explicit Grid(Mesh* mesh);
 
     void init();
 
+    void restore(std::map<int, std::vector<std::vector<double>>>& valuesMap);
+
     void computeTransfer();
 
     void computeIntegral(unsigned int gi1, unsigned int gi2);
@@ -38,22 +75,51 @@ public:
 
     void sync();
 
+    int rebalance(const std::vector<double>& workTimes);
+
     Mesh* getMesh() const {
         return _mesh;
     }
 
-    BaseCell* getCellById(int id) {
-        return _cellsMap[id];
-    }
+    // cell or nullptr if grid doesn't have it
+    BaseCell* getCellById(int id) const;
 
     const std::vector<std::shared_ptr<BaseCell>>& getCells() const {
         return _cells;
     }
 
+    int getMaxLevel() const {
+        return _maxLevel;
+    }
+
     void addCell(BaseCell* cell);
 
 private:
-    void normalizeVolume(Element* element, double& volume);
+    void initTimestep();
+
+    // sets levels of cells by their steps, returns max level
+    int initLevels();
+
+    void initFrontierLevel();
+
+    // volume of element over its biggest side
+    double getStep(int ei);
+
+    void computeLocalTransfer();
+
+    void computeImplicitTransfer();
+
+    void build(const std::map<int, std::shared_ptr<BaseCell>>& retainedCells);
+
+    void buildSyncPlan();
+
+    void buildSharedPlan();
+
+    void buildSweeps();
+
+    void addCell(const std::shared_ptr<BaseCell>& cell);
+
+    void normalizeVolume(Element::Type type, double& volume);
 
 };
 
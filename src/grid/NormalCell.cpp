@@ -1,8 +1,11 @@
 #include "NormalCell.h"
-#include "CellConnection.h"
+#include "CellConnections.h"
 #include "integral/ci.hpp"
 #include "integral/ci_impl.hpp"
 
+#include <algorithm>
+#include <cmath>
+
 void NormalCell::init() {
     auto config = Config::getInstance();
     const auto& gases = config->getGases();
@@ -29,34 +32,140 @@ void NormalCell::init() {
     }
 }
 
-void NormalCell::computeTransfer() {
+void NormalCell::restore(std::vector<std::vector<double>>&& values) {
+    _values = std::move(values);
+
+    // allocating space for new values
+    _newValues.resize(_values.size());
+    for (unsigned int gi = 0; gi < _values.size(); gi++) {
+        _newValues[gi].resize(_values[gi].size(), 0.0);
+    }
+}
+
+void NormalCell::computeTransfer(const CellConnections& connections) {
+    computeTransfer(connections, _values);
+}
+
+void NormalCell::computeTransfer(const CellConnections& connections, const std::vector<std::vector<double>>& startValues) {
     auto config = Config::getInstance();
     const auto& gases = config->getGases();
     const auto& impulses = config->getImpulseSphere()->getImpulses();
     auto timestep = config->getTimestep() / 2;
 
+    int begin = connections.getBegin(_index);
+    int end = connections.getEnd(_index);
     for (unsigned int gi = 0; gi < gases.size(); gi++) {
         double y = timestep / _volume / gases[gi].getMass();
 
         for (unsigned int ii = 0; ii < impulses.size(); ii++) {
+            const auto& impulse = impulses[ii];
             double sum = 0.0;
-            for (auto& connection : _connections) {
-                double projection = connection->getNormal21().scalar(impulses[ii]);
+            for (int ci = begin; ci < end; ci++) {
+
+                // projection onto normal from neighbor to cell
+                const double* normal = connections.getNormal(ci);
+                double projection = -(normal[0] * impulse.x() + normal[1] * impulse.y() + normal[2] * impulse.z());
                 if (projection != 0) {
                     double value;
                     if (projection < 0) {
-                        value = connection->getFirst()->getValues()[gi][ii];
+                        value = _values[gi][ii];
                     } else {
-                        value = connection->getSecond()->getValues()[gi][ii];
+                        value = connections.getNeighbor(ci)->getValues()[gi][ii];
                     }
-                    sum += value * projection * connection->getSquare();
+                    sum += value * projection * connections.getSquare(ci);
+                }
+            }
+            _newValues[gi][ii] = startValues[gi][ii] + sum * y;
+        }
+    }
+}
+
+void NormalCell::computeLocalTransfer(const CellConnections& connections, int step, double timestep) {
+    auto config = Config::getInstance();
+    const auto& gases = config->getGases();
+    const auto& impulses = config->getImpulseSphere()->getImpulses();
+
+    for (int ci = connections.getBegin(_index); ci < connections.getEnd(_index); ci++) {
+        BaseCell* neighbor = connections.getNeighbor(ci);
+
+        // side is passed at rate of finer cell, so both cells get the same flux through it
+        int level = std::min(_level, neighbor->getLevel());
+        if (step % (1 << level) != 0) {
+            continue;
+        }
+
+        const double* normal = connections.getNormal(ci);
+        double factor = connections.getSquare(ci) * (1 << level) * timestep / _volume;
+        for (unsigned int gi = 0; gi < gases.size(); gi++) {
+            double y = factor / gases[gi].getMass();
+            const auto& values = _values[gi];
+            const auto& neighborValues = neighbor->getValues()[gi];
+            auto& fluxes = _newValues[gi];
+
+            for (unsigned int ii = 0; ii < impulses.size(); ii++) {
+                const auto& impulse = impulses[ii];
+
+                // projection onto normal from neighbor to cell
+                double projection = -(normal[0] * impulse.x() + normal[1] * impulse.y() + normal[2] * impulse.z());
+                if (projection < 0) {
+                    fluxes[ii] += values[ii] * projection * y;
+                } else if (projection > 0) {
+                    fluxes[ii] += neighborValues[ii] * projection * y;
+                }
+            }
+        }
+    }
+}
+
+void NormalCell::applyLocalTransfer() {
+    for (unsigned int gi = 0; gi < _values.size(); gi++) {
+        for (unsigned int ii = 0; ii < _values[gi].size(); ii++) {
+            _values[gi][ii] += _newValues[gi][ii];
+            _newValues[gi][ii] = 0.0;
+        }
+    }
+}
+
+void NormalCell::startImplicitTransfer() {
+    for (unsigned int gi = 0; gi < _values.size(); gi++) {
+        std::copy(_values[gi].begin(), _values[gi].end(), _newValues[gi].begin());
+    }
+}
+
+void NormalCell::computeImplicitTransfer(const CellConnections& connections, const std::vector<int>& impulseIndexes) {
+    auto config = Config::getInstance();
+    const auto& gases = config->getGases();
+    const auto& impulses = config->getImpulseSphere()->getImpulses();
+    auto timestep = config->getTimestep() / 2;
+
+    int begin = connections.getBegin(_index);
+    int end = connections.getEnd(_index);
+    for (unsigned int gi = 0; gi < gases.size(); gi++) {
+        double y = timestep / _volume / gases[gi].getMass();
+
+        for (auto ii : impulseIndexes) {
+            const auto& impulse = impulses[ii];
+
+            // outflow is taken with new value of cell, inflow with latest values of neighbors
+            double sumIn = 0.0, sumOut = 0.0;
+            for (int ci = begin; ci < end; ci++) {
+                const double* normal = connections.getNormal(ci);
+                double projection = -(normal[0] * impulse.x() + normal[1] * impulse.y() + normal[2] * impulse.z());
+                if (projection < 0) {
+                    sumOut += projection * connections.getSquare(ci);
+                } else if (projection > 0) {
+                    sumIn += connections.getNeighbor(ci)->getValues()[gi][ii] * projection * connections.getSquare(ci);
                 }
             }
-            _newValues[gi][ii] = _values[gi][ii] + sum * y;
+            _values[gi][ii] = (_newValues[gi][ii] + sumIn * y) / (1 - sumOut * y);
         }
     }
 }
 
+void NormalCell::finishImplicitTransfer(const CellConnections& connections) {
+    computeTransfer(connections, _newValues);
+}
+
 void NormalCell::computeIntegral(int gi0, int gi1) {
     ci::iter(_values[gi0], _values[gi1]);
 }
@@ -88,6 +197,9 @@ void NormalCell::swapValues() {
 CellResults* NormalCell::getResults() {
     auto config = Config::getInstance();
     const auto& gases = config->getGases();
+    auto impulseSphere = config->getImpulseSphere();
+    const auto& impulses = impulseSphere->getImpulses();
+    double deltaImpulseQube = impulseSphere->getDeltaImpulseQube();
 
     // lazy initialization
     if (_results == nullptr) {
@@ -99,16 +211,43 @@ CellResults* NormalCell::getResults() {
 
     // fill results
     for (unsigned int gi = 0; gi < gases.size(); gi++) {
-        double density = compute_density(gi);
-        Vector3d flow = compute_stream(gi);
+        double mass = gases[gi].getMass();
+
+        // all raw moments in one pass: sum f, sum p f, sum p^2 f, sum p^2 p f
+        const double* values = _values[gi].data();
+        double s0 = 0.0, s1x = 0.0, s1y = 0.0, s1z = 0.0, s2 = 0.0, s3x = 0.0, s3y = 0.0, s3z = 0.0;
+        for (unsigned int ii = 0; ii < impulses.size(); ii++) {
+            double px = impulses[ii].x(), py = impulses[ii].y(), pz = impulses[ii].z();
+            double f = values[ii];
+            double p2 = px * px + py * py + pz * pz;
+            s0 += f;
+            s1x += px * f;
+            s1y += py * f;
+            s1z += pz * f;
+            s2 += p2 * f;
+            s3x += px * p2 * f;
+            s3y += py * p2 * f;
+            s3z += pz * p2 * f;
+        }
+
+        double density = s0 * deltaImpulseQube;
+        Vector3d flow(s1x, s1y, s1z);
+        flow *= deltaImpulseQube / mass;
 
         double temp = 0.0, pressure = 0.0;
         Vector3d heatFlow;
 
         if (density > 0.0) {
-            temp = compute_temperature(gi, density, flow);
-            pressure = compute_pressure(gi, density, temp);
-            heatFlow = compute_heatstream(gi);
+
+            // sum (p / m - u)^2 f = sum p^2 f / m^2 - 2 u sum p f / m + u^2 sum f
+            Vector3d averageSpeed = flow / density;
+            double s1u = s1x * averageSpeed.x() + s1y * averageSpeed.y() + s1z * averageSpeed.z();
+            double sum = s2 / mass / mass - 2 * s1u / mass + averageSpeed.moduleSquare() * s0;
+            temp = sum * mass * deltaImpulseQube / density / 3;
+            pressure = density * temp;
+
+            heatFlow = Vector3d(s3x, s3y, s3z);
+            heatFlow *= deltaImpulseQube / 2 / std::pow(mass, 2);
         }
         _results->set(gi, pressure, density, temp, flow, heatFlow);
     }
@@ -117,65 +256,28 @@ CellResults* NormalCell::getResults() {
     return _results.get();
 }
 
-double NormalCell::compute_density(int gi) {
-    auto config = Config::getInstance();
-    const auto& gases = config->getGases();
-    auto impulseSphere = config->getImpulseSphere();
-    const auto& impulses = config->getImpulseSphere()->getImpulses();
-
-    double density = 0.0;
-    for (unsigned int ii = 0; ii < impulses.size(); ii++) {
-        density += _values[gi][ii];
-    }
-    density *= impulseSphere->getDeltaImpulseQube();
-    return density;
-}
-
-double NormalCell::compute_temperature(int gi, double density, const Vector3d& stream) {
-    auto config = Config::getInstance();
-    const auto& gases = config->getGases();
-    auto impulseSphere = config->getImpulseSphere();
-    const auto& impulses = impulseSphere->getImpulses();
-
-    Vector3d averageSpeed = stream / density;
+bool NormalCell::getChange(double& change) {
+    auto results = getResults();
+    auto gasesSize = _values.size();
 
-    double temperature = 0.0;
-    for (unsigned int ii = 0; ii < impulses.size(); ii++) {
-        Vector3d vTemp = impulses[ii] / gases[gi].getMass() - averageSpeed;
-        temperature += vTemp.moduleSquare() * _values[gi][ii];
+    std::vector<double> macroparameters;
+    for (unsigned int gi = 0; gi < gasesSize; gi++) {
+        macroparameters.push_back(results->getDensity(gi));
+        macroparameters.push_back(results->getTemp(gi));
     }
-    temperature *= gases[gi].getMass() * impulseSphere->getDeltaImpulseQube() / density / 3;
-    return temperature;
-}
-
-double NormalCell::compute_pressure(int gi, double density, double temperature) {
-    return density * temperature;
-}
-
-Vector3d NormalCell::compute_stream(int gi) {
-    auto config = Config::getInstance();
-    const auto& gases = config->getGases();
-    auto impulseSphere = config->getImpulseSphere();
-    const auto& impulses = impulseSphere->getImpulses();
 
-    Vector3d stream;
-    for (unsigned int ii = 0; ii < impulses.size(); ii++) {
-        stream += impulses[ii] * _values[gi][ii];
+    change = 0.0;
+    bool hasChange = _lastMacroparameters.size() == macroparameters.size();
+    if (hasChange == true) {
+        for (unsigned int i = 0; i < macroparameters.size(); i++) {
+            double difference = std::abs(macroparameters[i] - _lastMacroparameters[i]);
+            if (_lastMacroparameters[i] != 0.0) {
+                difference /= std::abs(_lastMacroparameters[i]);
+            }
+            change = std::max(change, difference);
+        }
     }
-    stream *= impulseSphere->getDeltaImpulseQube() / gases[gi].getMass();
-    return stream;
-}
+    _lastMacroparameters = std::move(macroparameters);
 
-Vector3d NormalCell::compute_heatstream(int gi) {
-    auto config = Config::getInstance();
-    const auto& gases = config->getGases();
-    auto impulseSphere = config->getImpulseSphere();
-    const auto& impulses = impulseSphere->getImpulses();
-
-    Vector3d heatstream;
-    for (unsigned int ii = 0; ii < impulses.size(); ii++) {
-        heatstream += impulses[ii] * impulses[ii].moduleSquare() * _values[gi][ii];
-    }
-    heatstream *= impulseSphere->getDeltaImpulseQube() / 2 / std::pow(gases[gi].getMass(), 2);
-    return heatstream;
+    return hasChange;
 }
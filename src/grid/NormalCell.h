@@ -11,6 +11,7 @@ private:
     CellParameters _params;
     std::vector<std::vector<double>> _newValues;
     std::shared_ptr<CellResults> _results;
+    std::vector<double> _lastMacroparameters;
 
 public:
     NormalCell(int id, double volume) : BaseCell(Type::NORMAL, id) {
@@ -27,7 +28,22 @@ public:
 
     void init() override;
 
-    void computeTransfer() override;
+    void restore(std::vector<std::vector<double>>&& values);
+
+    void computeTransfer(const CellConnections& connections) override;
+
+    // gathers fluxes through sides passed at given smallest timestep, they are applied when cell is updated
+    void computeLocalTransfer(const CellConnections& connections, int step, double timestep);
+
+    void applyLocalTransfer();
+
+    // values of previous step are kept while implicit transfer is solved in place by sweeps over cells
+    void startImplicitTransfer();
+
+    void computeImplicitTransfer(const CellConnections& connections, const std::vector<int>& impulseIndexes);
+
+    // new values are found from previous ones by fluxes of solved values, so transfer stays conservative
+    void finishImplicitTransfer(const CellConnections& connections);
 
     void computeIntegral(int gi0, int gi1) override;
 
@@ -37,12 +53,13 @@ public:
 
     CellResults* getResults();
 
+    // biggest relative change of density and temperature of gases since last call,
+    // false when cell has no values of last call (first call or cell is just moved to process)
+    bool getChange(double& change);
+
 private:
-    double compute_density(int gi);
-    double compute_temperature(int gi, double density, const Vector3d& stream);
-    double compute_pressure(int gi, double density, double temperature);
-    Vector3d compute_stream(int gi);
-    Vector3d compute_heatstream(int gi);
+    // new values are start values with fluxes of current values
+    void computeTransfer(const CellConnections& connections, const std::vector<std::vector<double>>& startValues);
 
 };
 
@@ -1,5 +1,5 @@
 #include "ParallelCell.h"
-#include "CellConnection.h"
+#include "CellConnections.h"
 #include "parameters/ImpulseSphere.h"
 #include "parameters/Gas.h"
 #include "core/Config.h"
@@ -22,7 +22,7 @@ void ParallelCell::init() {
     }
 }
 
-void ParallelCell::computeTransfer() {
+void ParallelCell::computeTransfer(const CellConnections& connections) {
     // nothing
 }
 
@@ -42,10 +42,10 @@ int ParallelCell::getSyncProcessId() const {
     return _syncProcessId;
 }
 
-std::vector<int> ParallelCell::getSendSyncIds() {
+std::vector<int> ParallelCell::getSendSyncIds(const CellConnections& connections) const {
     std::vector<int> sendSyncIds;
-    for (const auto& connection : _connections) {
-        sendSyncIds.push_back(connection->getSecond()->getId());
+    for (int ci = connections.getBegin(_index); ci < connections.getEnd(_index); ci++) {
+        sendSyncIds.push_back(connections.getNeighbor(ci)->getId());
     }
     return sendSyncIds;
 }
@@ -13,7 +13,7 @@ public:
 
     void init() override;
 
-    void computeTransfer() override;
+    void computeTransfer(const CellConnections& connections) override;
 
     void computeIntegral(int gi0, int gi1) override;
 
@@ -23,7 +23,7 @@ public:
 
     int getSyncProcessId() const;
 
-    std::vector<int> getSendSyncIds();
+    std::vector<int> getSendSyncIds(const CellConnections& connections) const;
 };
 
 
@@ -0,0 +1,68 @@
+#include "Element.h"
+#include "Point.h"
+#include "Line.h"
+#include "Triangle.h"
+#include "Quadrangle.h"
+#include "Tetrahedron.h"
+#include "Hexahedron.h"
+#include "Prism.h"
+
+bool Element::isSupported(int type) {
+    switch (static_cast<Type>(type)) {
+        case Type::POINT:
+        case Type::LINE:
+        case Type::TRIANGLE:
+        case Type::QUADRANGLE:
+        case Type::TETRAHEDRON:
+        case Type::HEXAHEDRON:
+        case Type::PRISM:
+            return true;
+    }
+    return false;
+}
+
+double Element::getVolume(Type type, const std::vector<Vector3d>& positions) {
+    switch (type) {
+        case Type::POINT:
+            return Point::getVolume(positions);
+        case Type::LINE:
+            return Line::getVolume(positions);
+        case Type::TRIANGLE:
+            return Triangle::getVolume(positions);
+        case Type::QUADRANGLE:
+            return Quadrangle::getVolume(positions);
+        case Type::TETRAHEDRON:
+            return Tetrahedron::getVolume(positions);
+        case Type::HEXAHEDRON:
+            return Hexahedron::getVolume(positions);
+        case Type::PRISM:
+            return Prism::getVolume(positions);
+    }
+    return 0.0;
+}
+
+void Element::getSides(Type type, const std::vector<Vector3d>& positions, std::vector<Side>& sides) {
+    switch (type) {
+        case Type::POINT:
+            Point::getSides(positions, sides);
+            break;
+        case Type::LINE:
+            Line::getSides(positions, sides);
+            break;
+        case Type::TRIANGLE:
+            Triangle::getSides(positions, sides);
+            break;
+        case Type::QUADRANGLE:
+            Quadrangle::getSides(positions, sides);
+            break;
+        case Type::TETRAHEDRON:
+            Tetrahedron::getSides(positions, sides);
+            break;
+        case Type::HEXAHEDRON:
+            Hexahedron::getSides(positions, sides);
+            break;
+        case Type::PRISM:
+            Prism::getSides(positions, sides);
+            break;
+    }
+}
@@ -2,37 +2,22 @@
 #define RGS_LINE_H
 
 #include "Element.h"
-#include "Point.h"
 
 #include <cmath>
 
-class Line : public Element {
-    friend class boost::serialization::access;
-
+class Line {
 public:
-    Line() = default;
-
-    Line(int id, int physicalEntityId, int geomUnitId, const std::vector<int>& partitions, const std::vector<int>& nodeIds)
-    : Element(Type::LINE, id, physicalEntityId, geomUnitId, partitions, nodeIds) {}
-
-    explicit Line(const std::vector<int>& nodeIds) : Line(0, -1, -1, {}, nodeIds) {}
-
-private:
-    template<class Archive>
-    void serialize(Archive & ar, const unsigned int version) {
-        ar & boost::serialization::base_object<Element>(*this);
+    static double getVolume(const std::vector<Vector3d>& positions) {
+        Vector3d a = positions[1] - positions[0];
+        return a.module();
     }
 
-    void innerInit(const std::vector<Node*>& nodes, bool isSideElementsRequired) override {
-        Vector3d a = nodes[1]->getPosition() - nodes[0]->getPosition();
-
-        if (isSideElementsRequired) {
-            _sideElements.clear();
-            _sideElements.emplace_back(new SideElement(new Point({nodes[0]->getId()}), -Vector3d(a).normalize()));
-            _sideElements.emplace_back(new SideElement(new Point({nodes[1]->getId()}), Vector3d(a).normalize()));
-        }
+    static void getSides(const std::vector<Vector3d>& positions, std::vector<Element::Side>& sides) {
+        Vector3d a = positions[1] - positions[0];
 
-        _volume = a.module();
+        sides.clear();
+        sides.emplace_back(Element::Type::POINT, std::initializer_list<int>{0}, -Vector3d(a).normalize());
+        sides.emplace_back(Element::Type::POINT, std::initializer_list<int>{1}, Vector3d(a).normalize());
     }
 };
 
@@ -1,79 +1,244 @@
 #include "Mesh.h"
-#include "Point.h"
-#include "Line.h"
-#include "Triangle.h"
-#include "Quadrangle.h"
-#include "Tetrahedron.h"
-#include "Hexahedron.h"
-#include "Prism.h"
 #include "utilities/Utils.h"
-#include "utilities/Normalizer.h"
-#include "core/Config.h"
 
 #include <iostream>
 #include <stdexcept>
+#include <array>
+#include <algorithm>
+#include <unordered_map>
+#include <thread>
+
+#include <boost/functional/hash.hpp>
+
+// sorted node indexes of face, sides of elements have at most 4 nodes
+struct FaceKey {
+    std::array<int, 4> nodes;
+    std::size_t size;
+
+    bool operator==(const FaceKey& other) const {
+        return size == other.size && std::equal(nodes.begin(), nodes.begin() + size, other.nodes.begin());
+    }
+};
+
+struct FaceKeyHash {
+    std::size_t operator()(const FaceKey& key) const {
+        return boost::hash_range(key.nodes.begin(), key.nodes.begin() + key.size);
+    }
+};
+
+// indexes of first two elements having face
+struct FaceElements {
+    int first = -1;
+    int second = -1;
+};
+
+// key of face with more than 4 nodes is empty, such face can't be shared
+static void makeFaceKey(const int* begin, const int* end, FaceKey& key) {
+    if (end - begin > static_cast<std::ptrdiff_t>(key.nodes.size())) {
+        key.size = 0;
+        return;
+    }
+    key.size = static_cast<std::size_t>(end - begin);
+    std::copy(begin, end, key.nodes.begin());
+    std::sort(key.nodes.begin(), key.nodes.begin() + key.size);
+}
+
+// sides of chunk of elements
+struct SidesChunk {
+    std::vector<int> sidesSizes;
+    std::vector<Element::Type> types;
+    std::vector<int> nodesSizes;
+    std::vector<int> nodes;
+    std::vector<double> normals;
+    std::vector<double> volumes;
+};
+
+// preprocessing in threads isn't worth it for smaller chunks
+static const int MIN_CHUNK_SIZE = 1 << 14;
+
+static std::size_t getChunksSize(int elementsSize) {
+    std::size_t chunksSize = std::max(1u, std::thread::hardware_concurrency());
+    return std::max<std::size_t>(1, std::min<std::size_t>(chunksSize, elementsSize / MIN_CHUNK_SIZE));
+}
+
+// index of id in dense map, map grows for new id
+static int& getIndex(std::vector<int>& indexes, int id) {
+    if (id < 0) {
+        throw std::runtime_error("wrong id: " + std::to_string(id));
+    }
+    if (id >= static_cast<int>(indexes.size())) {
+        indexes.resize(static_cast<std::size_t>(id) + 1, -1);
+    }
+    return indexes[id];
+}
+
+Mesh::Mesh() : _nodesOffsets(1, 0), _sidesOffsets(1, 0), _sideNodesOffsets(1, 0) {}
 
 void Mesh::init() {
+    initGroups();
 
-    // pre-process elements (find physical entities)
-    for (const auto& element : _elements) {
-        auto entityId = element->getPhysicalEntityId();
-        auto entity = _physicalEntitiesMap.at(entityId);
+    // elements are split into chunks done by own threads, results of chunks are joined
+    // in order of elements, so mesh doesn't depend on number of threads
+    auto elementsSize = getElementsSize();
+    auto chunksSize = getChunksSize(elementsSize);
+    auto getChunkBegin = [elementsSize, chunksSize](std::size_t ci) {
+        return static_cast<int>(static_cast<std::size_t>(elementsSize) * ci / chunksSize);
+    };
 
-        // element without entity (cannot setup initial or border params, junk element)
-        if (entity == nullptr) {
-            continue;
+    // create sides and calculate volume of main elements
+    std::vector<SidesChunk> sidesChunks(chunksSize);
+    Utils::forEachChunk(chunksSize, [&](std::size_t ci) {
+        auto& chunk = sidesChunks[ci];
+        std::vector<Vector3d> positions;
+        std::vector<Vector3d> sidePositions;
+        std::vector<Element::Side> sides;
+        for (int ei = getChunkBegin(ci); ei < getChunkBegin(ci + 1); ei++) {
+            if (isMain(ei) == false) {
+                chunk.sidesSizes.push_back(0);
+                continue;
+            }
+            auto nodes = getElementNodes(ei);
+            positions.clear();
+            for (auto node : nodes) {
+                positions.push_back(getNodePosition(node));
+            }
+            _volumes[ei] = Element::getVolume(_elementTypes[ei], positions);
+
+            Element::getSides(_elementTypes[ei], positions, sides);
+            for (const auto& side : sides) {
+                sidePositions.clear();
+                for (int i = 0; i < side.nodesSize; i++) {
+                    chunk.nodes.push_back(nodes[side.nodes[i]]);
+                    sidePositions.push_back(positions[side.nodes[i]]);
+                }
+                chunk.nodesSizes.push_back(side.nodesSize);
+                chunk.types.push_back(side.type);
+                chunk.normals.insert(chunk.normals.end(), {side.normal.x(), side.normal.y(), side.normal.z()});
+                chunk.volumes.push_back(Element::getVolume(side.type, sidePositions));
+            }
+            chunk.sidesSizes.push_back(static_cast<int>(sides.size()));
         }
+    });
 
-        element->setGroup(entity->getName());
+    _sideTypes.clear();
+    _sideNodesOffsets.assign(1, 0);
+    _sideNodes.clear();
+    _sideNormals.clear();
+    _sideVolumes.clear();
+    _sidesOffsets.assign(1, 0);
+    for (const auto& chunk : sidesChunks) {
+        for (auto sidesSize : chunk.sidesSizes) {
+            _sidesOffsets.push_back(_sidesOffsets.back() + sidesSize);
+        }
+        for (auto nodesSize : chunk.nodesSizes) {
+            _sideNodesOffsets.push_back(_sideNodesOffsets.back() + nodesSize);
+        }
+        _sideTypes.insert(_sideTypes.end(), chunk.types.begin(), chunk.types.end());
+        _sideNodes.insert(_sideNodes.end(), chunk.nodes.begin(), chunk.nodes.end());
+        _sideNormals.insert(_sideNormals.end(), chunk.normals.begin(), chunk.normals.end());
+        _sideVolumes.insert(_sideVolumes.end(), chunk.volumes.begin(), chunk.volumes.end());
     }
+    _sideNeighborIds.assign(_sideTypes.size(), 0);
+    sidesChunks.clear();
 
-    // create side elements and calculate volume
-    for (const auto& element : _elements) {
-        if (element->isMain() == true) {
-            element->init(_nodesMap, true);
+    // face keys of each element and of its sides, element key is followed by keys of its sides
+    auto getKeysBegin = [this](int ei) {
+        return ei + _sidesOffsets[ei];
+    };
+    std::vector<FaceKey> keys(_elementIds.size() + _sideTypes.size());
+    std::vector<std::size_t> hashes(keys.size());
+    Utils::forEachChunk(chunksSize, [&](std::size_t ci) {
+        FaceKeyHash hash;
+        for (int ei = getChunkBegin(ci); ei < getChunkBegin(ci + 1); ei++) {
+            auto ki = getKeysBegin(ei);
+            auto nodes = getElementNodes(ei);
+            makeFaceKey(nodes.begin(), nodes.end(), keys[ki]);
+            for (int si = getSidesBegin(ei); si < getSidesEnd(ei); si++) {
+                ki++;
+                makeFaceKey(_sideNodes.data() + _sideNodesOffsets[si], _sideNodes.data() + _sideNodesOffsets[si + 1], keys[ki]);
+            }
         }
-    }
+        for (int ei = getChunkBegin(ci); ei < getChunkBegin(ci + 1); ei++) {
+            for (int ki = getKeysBegin(ei); ki < getKeysBegin(ei + 1); ki++) {
+                hashes[ki] = hash(keys[ki]);
+            }
+        }
+    });
 
-    // preprocess mesh (find all neighbors)
-    for (const auto& element : _elements) {
-        if (element->isMain() == false) {
-            continue;
+    // face table: first two elements with such face, table is split into shards by hash,
+    // each shard is filled by own thread in order of elements
+    std::vector<std::unordered_map<FaceKey, FaceElements, FaceKeyHash>> shards(chunksSize);
+    Utils::forEachChunk(chunksSize, [&](std::size_t ci) {
+        auto& faces = shards[ci];
+        faces.reserve(keys.size() / chunksSize + 1);
+        for (int ei = 0; ei < elementsSize; ei++) {
+            for (int ki = getKeysBegin(ei); ki < getKeysBegin(ei + 1); ki++) {
+                if (keys[ki].size == 0 || hashes[ki] % chunksSize != ci) {
+                    continue;
+                }
+                auto& face = faces[keys[ki]];
+                if (face.first == -1) {
+                    face.first = ei;
+                } else if (face.second == -1 && face.first != ei) {
+                    face.second = ei;
+                }
+            }
         }
+    });
 
-        // find all neighbors (common nodes)
-        for (const auto& sideElement : element->getSideElements()) {
-
-            // each side element can have neighbor or don't have one
-            auto predicate = [&element, &sideElement](const std::shared_ptr<Element>& otherElement) {
-                return otherElement->getId() != element->getId() && otherElement->isSideOrContainsSide(sideElement.get());
-            };
-            auto result = std::find_if(_elements.begin(), _elements.end(), predicate);
-            if (result != _elements.end()) {
-                const auto& otherElement = *result;
-                sideElement->setNeighborId(otherElement->getId());
-            } else {
-                throw std::runtime_error("main element doesn't have any neighbors");
+    // preprocess mesh (find all neighbors), each side has neighbor, first other element in mesh with the same face
+    Utils::forEachChunk(chunksSize, [&](std::size_t ci) {
+        for (int ei = getChunkBegin(ci); ei < getChunkBegin(ci + 1); ei++) {
+            for (int si = getSidesBegin(ei); si < getSidesEnd(ei); si++) {
+                auto ki = getKeysBegin(ei) + 1 + (si - getSidesBegin(ei));
+                int neighborIndex = -1;
+                if (keys[ki].size != 0) {
+                    const auto& faces = shards[hashes[ki] % chunksSize];
+                    auto it = faces.find(keys[ki]);
+                    if (it != faces.end()) {
+                        neighborIndex = it->second.first != ei ? it->second.first : it->second.second;
+                    }
+                }
+                if (neighborIndex != -1) {
+                    _sideNeighborIds[si] = _elementIds[neighborIndex];
+                } else {
+                    throw std::runtime_error("main element doesn't have any neighbors");
+                }
             }
         }
+    });
+}
+
+void Mesh::initGroups() {
+
+    // pre-process elements (find physical entities), element without entity
+    // cannot setup initial or border params, it is junk element
+    _groups.assign(_elementIds.size(), -1);
+    for (std::size_t ei = 0; ei < _elementIds.size(); ei++) {
+        auto entity = _physicalEntityIndexes.find(_physicalEntityIds[ei]);
+        if (entity != _physicalEntityIndexes.end()) {
+            _groups[ei] = entity->second;
+        }
     }
 }
 
 void Mesh::resetMaps() {
-    _physicalEntitiesMap.clear();
-    for (const auto& entity : _physicalEntities) {
-        _physicalEntitiesMap[entity->getId()] = entity.get();
+    _physicalEntityIndexes.clear();
+    for (std::size_t i = 0; i < _physicalEntities.size(); i++) {
+        _physicalEntityIndexes[_physicalEntities[i].getId()] = static_cast<int>(i);
     }
 
-    _nodesMap.clear();
-    for (const auto& node : _nodes) {
-        _nodesMap[node->getId()] = node.get();
+    _nodeIndexes.clear();
+    for (std::size_t i = 0; i < _nodeIds.size(); i++) {
+        getIndex(_nodeIndexes, _nodeIds[i]) = static_cast<int>(i);
     }
 
-    _elementsMap.clear();
-    for (const auto& element : _elements) {
-        _elementsMap[element->getId()] = element.get();
+    _elementIndexes.clear();
+    for (std::size_t i = 0; i < _elementIds.size(); i++) {
+        getIndex(_elementIndexes, _elementIds[i]) = static_cast<int>(i);
     }
+
+    initGroups();
 }
 
 void Mesh::reservePhysicalEntities(std::size_t capacity) {
@@ -81,90 +246,148 @@ void Mesh::reservePhysicalEntities(std::size_t capacity) {
 }
 
 void Mesh::addPhysicalEntity(int dimension, int id, std::string name) {
-   addPhysicalEntity(new PhysicalEntity(dimension, id, std::move(name)));
-}
-
-void Mesh::addPhysicalEntity(PhysicalEntity* physicalEntity) {
-    if (_physicalEntitiesMap[physicalEntity->getId()] == nullptr) {
-        _physicalEntitiesMap[physicalEntity->getId()] = physicalEntity;
-        _physicalEntities.emplace_back(physicalEntity);
+    if (_physicalEntityIndexes.count(id) == 0) {
+        _physicalEntityIndexes[id] = static_cast<int>(_physicalEntities.size());
+        _physicalEntities.emplace_back(dimension, id, std::move(name));
     }
 }
 
-PhysicalEntity* Mesh::getPhysicalEntity(int id) const {
-    return _physicalEntitiesMap.at(id);
-}
-
-const std::vector<std::shared_ptr<PhysicalEntity>>& Mesh::getPhysicalEntities() const {
+const std::vector<PhysicalEntity>& Mesh::getPhysicalEntities() const {
     return _physicalEntities;
 }
 
 void Mesh::reserveNodes(std::size_t capacity) {
-    _nodes.reserve(capacity);
+    _nodeIds.reserve(capacity);
+    _nodeCoordinates.reserve(capacity * 3);
 }
 
-void Mesh::addNode(int id, Vector3d position) {
-    addNode(new Node(id, std::move(position)));
+void Mesh::addNode(int id, const Vector3d& position) {
+    auto& index = getIndex(_nodeIndexes, id);
+    if (index == -1) {
+        index = static_cast<int>(_nodeIds.size());
+        _nodeIds.push_back(id);
+        _nodeCoordinates.insert(_nodeCoordinates.end(), {position.x(), position.y(), position.z()});
+    }
 }
 
-void Mesh::addNode(Node* node) {
-    if (_nodesMap[node->getId()] == nullptr) {
-        _nodesMap[node->getId()] = node;
-        _nodes.emplace_back(node);
+void Mesh::reserveElements(std::size_t capacity) {
+    _elementIds.reserve(capacity);
+    _elementTypes.reserve(capacity);
+    _physicalEntityIds.reserve(capacity);
+    _geomUnitIds.reserve(capacity);
+    _processIds.reserve(capacity);
+    _nodesOffsets.reserve(capacity + 1);
+    _volumes.reserve(capacity);
+    _groups.reserve(capacity);
+    _sidesOffsets.reserve(capacity + 1);
+}
+
+void Mesh::addElement(int id, int type, int physicalEntityId, int geomUnitId, const std::vector<int>& partitions, const std::vector<int>& nodeIds) {
+    auto& index = getIndex(_elementIndexes, id);
+    if (index != -1) {
+        return;
     }
+    if (Element::isSupported(type) == false) {
+        throw std::runtime_error("element " + std::to_string(id) + " has unsupported type " + std::to_string(type));
+    }
+    for (auto nodeId : nodeIds) {
+        auto node = getNodeIndex(nodeId);
+        if (node == -1) {
+            throw std::runtime_error("element " + std::to_string(id) + " has unknown node " + std::to_string(nodeId));
+        }
+        _elementNodes.push_back(node);
+    }
+    _nodesOffsets.push_back(static_cast<int>(_elementNodes.size()));
+
+    index = static_cast<int>(_elementIds.size());
+    _elementIds.push_back(id);
+    _elementTypes.push_back(static_cast<Element::Type>(type));
+    _physicalEntityIds.push_back(physicalEntityId);
+    _geomUnitIds.push_back(geomUnitId);
+    _processIds.push_back(!partitions.empty() ? (partitions[0] - 1) : -1);
+    _volumes.push_back(0.0);
+
+    auto entity = _physicalEntityIndexes.find(physicalEntityId);
+    _groups.push_back(entity != _physicalEntityIndexes.end() ? entity->second : -1);
+
+    _sidesOffsets.push_back(_sidesOffsets.back());
 }
 
-Node* Mesh::getNode(int id) const {
-    return _nodesMap.at(id);
+const std::string& Mesh::getGroup(int index) const {
+    static const std::string empty;
+    return _groups[index] != -1 ? _physicalEntities[_groups[index]].getName() : empty;
 }
 
-const std::vector<std::shared_ptr<Node>>& Mesh::getNodes() const {
-    return _nodes;
+Mesh* Mesh::createSubmesh(const std::vector<int>& elementIds) const {
+    auto submesh = new Mesh();
+
+    for (const auto& entity : _physicalEntities) {
+        submesh->addPhysicalEntity(entity.getDimension(), entity.getId(), entity.getName());
+    }
+
+    // elements with their neighbors (one layer of halo and border elements)
+    for (auto elementId : elementIds) {
+        auto index = getElementIndex(elementId);
+        if (index == -1) {
+            throw std::runtime_error("no element with id " + std::to_string(elementId));
+        }
+        submesh->copyElement(*this, index);
+        for (int si = getSidesBegin(index); si < getSidesEnd(index); si++) {
+            submesh->copyElement(*this, getElementIndex(_sideNeighborIds[si]));
+        }
+    }
+
+    return submesh;
 }
 
-void Mesh::reserveElements(std::size_t capacity) {
-    _elements.reserve(capacity);
+void Mesh::merge(const Mesh& other) {
+    for (const auto& entity : other._physicalEntities) {
+        addPhysicalEntity(entity.getDimension(), entity.getId(), entity.getName());
+    }
+    for (int ni = 0; ni < other.getNodesSize(); ni++) {
+        addNode(other.getNodeId(ni), other.getNodePosition(ni));
+    }
+    for (int ei = 0; ei < other.getElementsSize(); ei++) {
+        copyElement(other, ei);
+    }
 }
 
-void Mesh::addElement(int id, int type, int physicalEntityId, int geomUnitId, const std::vector<int>& partitions, const std::vector<int>& nodeIds) {
-    Element* element = nullptr;
-    switch (static_cast<Element::Type>(type)) {
-        case Element::Type::POINT:
-            element = new Point(id, physicalEntityId, geomUnitId, partitions, nodeIds);
-            break;
-        case Element::Type::LINE:
-            element = new Line(id, physicalEntityId, geomUnitId, partitions, nodeIds);
-            break;
-        case Element::Type::TRIANGLE:
-            element = new Triangle(id, physicalEntityId, geomUnitId, partitions, nodeIds);
-            break;
-        case Element::Type::QUADRANGLE:
-            element = new Quadrangle(id, physicalEntityId, geomUnitId, partitions, nodeIds);
-            break;
-        case Element::Type::TETRAHEDRON:
-            element = new Tetrahedron(id, physicalEntityId, geomUnitId, partitions, nodeIds);
-            break;
-        case Element::Type::HEXAHEDRON:
-            element = new Hexahedron(id, physicalEntityId, geomUnitId, partitions, nodeIds);
-            break;
-        case Element::Type::PRISM:
-            element = new Prism(id, physicalEntityId, geomUnitId, partitions, nodeIds);
-            break;
-    }
-    addElement(element);
-}
-
-void Mesh::addElement(Element* element) {
-    if (_elementsMap[element->getId()] == nullptr) {
-        _elementsMap[element->getId()] = element;
-        _elements.emplace_back(element);
-    }
-}
-
-Element* Mesh::getElement(int id) const {
-    return _elementsMap.at(id);
-}
-
-const std::vector<std::shared_ptr<Element>>& Mesh::getElements() const {
-    return _elements;
+void Mesh::copyElement(const Mesh& other, int index) {
+    auto& elementIndex = getIndex(_elementIndexes, other._elementIds[index]);
+    if (elementIndex != -1) {
+        return;
+    }
+
+    // nodes used by element are taken in order of elements
+    auto toNode = [this, &other](int otherNode) {
+        addNode(other.getNodeId(otherNode), other.getNodePosition(otherNode));
+        return _nodeIndexes[other.getNodeId(otherNode)];
+    };
+    for (auto node : other.getElementNodes(index)) {
+        _elementNodes.push_back(toNode(node));
+    }
+    _nodesOffsets.push_back(static_cast<int>(_elementNodes.size()));
+
+    elementIndex = static_cast<int>(_elementIds.size());
+    _elementIds.push_back(other._elementIds[index]);
+    _elementTypes.push_back(other._elementTypes[index]);
+    _physicalEntityIds.push_back(other._physicalEntityIds[index]);
+    _geomUnitIds.push_back(other._geomUnitIds[index]);
+    _processIds.push_back(other._processIds[index]);
+    _volumes.push_back(other._volumes[index]);
+
+    auto entity = _physicalEntityIndexes.find(other._physicalEntityIds[index]);
+    _groups.push_back(entity != _physicalEntityIndexes.end() ? entity->second : -1);
+
+    for (int si = other.getSidesBegin(index); si < other.getSidesEnd(index); si++) {
+        for (int ni = other._sideNodesOffsets[si]; ni < other._sideNodesOffsets[si + 1]; ni++) {
+            _sideNodes.push_back(toNode(other._sideNodes[ni]));
+        }
+        _sideNodesOffsets.push_back(static_cast<int>(_sideNodes.size()));
+        _sideTypes.push_back(other._sideTypes[si]);
+        _sideNormals.insert(_sideNormals.end(), other._sideNormals.begin() + 3 * si, other._sideNormals.begin() + 3 * (si + 1));
+        _sideVolumes.push_back(other._sideVolumes[si]);
+        _sideNeighborIds.push_back(other._sideNeighborIds[si]);
+    }
+    _sidesOffsets.push_back(static_cast<int>(_sideTypes.size()));
 }
@@ -2,28 +2,79 @@
 #define RGS_MESH_H
 
 #include "PhysicalEntity.h"
-#include "Node.h"
 #include "Element.h"
 
 #include <vector>
 #include <map>
-#include <memory>
-#include <boost/serialization/shared_ptr.hpp>
-#include <boost/serialization/map.hpp>
+#include <string>
+#include <boost/serialization/vector.hpp>
 
+// read only view of part of flat array
+template<typename T>
+class Slice {
+private:
+    const T* _begin;
+    const T* _end;
+
+public:
+    Slice(const T* begin, const T* end) : _begin(begin), _end(end) {}
+
+    const T* begin() const {
+        return _begin;
+    }
+
+    const T* end() const {
+        return _end;
+    }
+
+    std::size_t size() const {
+        return static_cast<std::size_t>(_end - _begin);
+    }
+
+    const T& operator[](std::size_t i) const {
+        return _begin[i];
+    }
+};
+
+// mesh is kept in flat arrays: nodes, elements and sides are addressed by dense indexes,
+// ids of mesh file are mapped to indexes, nodes of elements and sides of elements are kept
+// in CSR form (offsets of each element into common array)
 class Mesh {
     friend class boost::serialization::access;
+    friend class MeshCache;
 
 private:
-    std::vector<std::shared_ptr<PhysicalEntity>> _physicalEntities;
-    std::map<int, PhysicalEntity*> _physicalEntitiesMap;
-    std::vector<std::shared_ptr<Node>> _nodes;
-    std::map<int, Node*> _nodesMap;
-    std::vector<std::shared_ptr<Element>> _elements;
-    std::map<int, Element*> _elementsMap;
+    std::vector<PhysicalEntity> _physicalEntities;
+    std::map<int, int> _physicalEntityIndexes;
+
+    // nodes, coordinates are x, y, z of each node
+    std::vector<int> _nodeIds;
+    std::vector<double> _nodeCoordinates;
+    std::vector<int> _nodeIndexes;
+
+    // elements, nodes are node indexes
+    std::vector<int> _elementIds;
+    std::vector<Element::Type> _elementTypes;
+    std::vector<int> _physicalEntityIds;
+    std::vector<int> _geomUnitIds;
+    std::vector<int> _processIds;
+    std::vector<int> _nodesOffsets;
+    std::vector<int> _elementNodes;
+    std::vector<double> _volumes;
+    std::vector<int> _groups;
+    std::vector<int> _elementIndexes;
+
+    // sides of main elements with outer normals and ids of neighbor elements
+    std::vector<int> _sidesOffsets;
+    std::vector<Element::Type> _sideTypes;
+    std::vector<int> _sideNodesOffsets;
+    std::vector<int> _sideNodes;
+    std::vector<double> _sideNormals;
+    std::vector<double> _sideVolumes;
+    std::vector<int> _sideNeighborIds;
 
 public:
-    Mesh() = default;
+    Mesh();
 
     void init();
 
@@ -33,38 +84,146 @@ public:
 
     void addPhysicalEntity(int dimension, int id, std::string name);
 
-    void addPhysicalEntity(PhysicalEntity* physicalEntity);
-
-    PhysicalEntity* getPhysicalEntity(int id) const;
-
-    const std::vector<std::shared_ptr<PhysicalEntity>>& getPhysicalEntities() const;
+    const std::vector<PhysicalEntity>& getPhysicalEntities() const;
 
     void reserveNodes(std::size_t capacity);
 
-    void addNode(int id, Vector3d position);
+    void addNode(int id, const Vector3d& position);
 
-    void addNode(Node* node);
+    int getNodesSize() const {
+        return static_cast<int>(_nodeIds.size());
+    }
+
+    // index of node or -1
+    int getNodeIndex(int id) const {
+        return id >= 0 && id < static_cast<int>(_nodeIndexes.size()) ? _nodeIndexes[id] : -1;
+    }
 
-    Node* getNode(int id) const;
+    int getNodeId(int index) const {
+        return _nodeIds[index];
+    }
 
-    const std::vector<std::shared_ptr<Node>>& getNodes() const;
+    Vector3d getNodePosition(int index) const {
+        const double* coordinates = _nodeCoordinates.data() + 3 * index;
+        return Vector3d(coordinates[0], coordinates[1], coordinates[2]);
+    }
 
     void reserveElements(std::size_t capacity);
 
     void addElement(int id, int type, int physicalEntityId, int geomUnitId, const std::vector<int>& partitions, const std::vector<int>& nodeIds);
 
-    void addElement(Element* element);
+    int getElementsSize() const {
+        return static_cast<int>(_elementIds.size());
+    }
 
-    Element* getElement(int id) const;
+    // index of element or -1
+    int getElementIndex(int id) const {
+        return id >= 0 && id < static_cast<int>(_elementIndexes.size()) ? _elementIndexes[id] : -1;
+    }
 
-    const std::vector<std::shared_ptr<Element>>& getElements() const;
+    bool hasElement(int id) const {
+        return getElementIndex(id) != -1;
+    }
+
+    int getElementId(int index) const {
+        return _elementIds[index];
+    }
+
+    Element::Type getElementType(int index) const {
+        return _elementTypes[index];
+    }
+
+    int getPhysicalEntityId(int index) const {
+        return _physicalEntityIds[index];
+    }
+
+    int getProcessId(int index) const {
+        return _processIds[index];
+    }
+
+    void setProcessId(int index, int processId) {
+        _processIds[index] = processId;
+    }
+
+    // node indexes of element
+    Slice<int> getElementNodes(int index) const {
+        return {_elementNodes.data() + _nodesOffsets[index], _elementNodes.data() + _nodesOffsets[index + 1]};
+    }
+
+    double getVolume(int index) const {
+        return _volumes[index];
+    }
+
+    // name of physical entity of element, empty for junk elements
+    const std::string& getGroup(int index) const;
+
+    bool isMain(int index) const {
+        return _groups[index] != -1 && _physicalEntities[_groups[index]].isMain();
+    }
+
+    bool isBorder(int index) const {
+        return _groups[index] != -1 && _physicalEntities[_groups[index]].isBorder();
+    }
+
+    // sides of element are indexes from begin to end
+    int getSidesBegin(int index) const {
+        return _sidesOffsets[index];
+    }
+
+    int getSidesEnd(int index) const {
+        return _sidesOffsets[index + 1];
+    }
+
+    Element::Type getSideType(int side) const {
+        return _sideTypes[side];
+    }
+
+    Vector3d getSideNormal(int side) const {
+        const double* normal = _sideNormals.data() + 3 * side;
+        return Vector3d(normal[0], normal[1], normal[2]);
+    }
+
+    double getSideVolume(int side) const {
+        return _sideVolumes[side];
+    }
+
+    int getSideNeighborId(int side) const {
+        return _sideNeighborIds[side];
+    }
+
+    Mesh* createSubmesh(const std::vector<int>& elementIds) const;
+
+    void merge(const Mesh& other);
 
 private:
+    void initGroups();
+
+    // copies element with its nodes and sides from other mesh, if mesh doesn't have it
+    void copyElement(const Mesh& other, int index);
+
     template<class Archive>
     void serialize(Archive & ar, const unsigned int version) {
         ar & _physicalEntities;
-        ar & _nodes;
-        ar & _elements;
+
+        ar & _nodeIds;
+        ar & _nodeCoordinates;
+
+        ar & _elementIds;
+        ar & _elementTypes;
+        ar & _physicalEntityIds;
+        ar & _geomUnitIds;
+        ar & _processIds;
+        ar & _nodesOffsets;
+        ar & _elementNodes;
+        ar & _volumes;
+
+        ar & _sidesOffsets;
+        ar & _sideTypes;
+        ar & _sideNodesOffsets;
+        ar & _sideNodes;
+        ar & _sideNormals;
+        ar & _sideVolumes;
+        ar & _sideNeighborIds;
     }
 
 };
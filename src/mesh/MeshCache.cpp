@@ -0,0 +1,237 @@
+#include "MeshCache.h"
+#include "Mesh.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+#include <boost/filesystem.hpp>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace boost::filesystem;
+
+struct MeshCacheHeader {
+    char signature[8];
+    std::uint64_t key;
+    double units;
+};
+
+static const char SIGNATURE[8] = {'R', 'G', 'S', 'M', 'S', 'H', '0', '2'};
+
+// FNV-1a
+static std::uint64_t hash(const char* data, std::size_t size, std::uint64_t value = 14695981039346656037ull) {
+    for (std::size_t i = 0; i < size; i++) {
+        value ^= static_cast<unsigned char>(data[i]);
+        value *= 1099511628211ull;
+    }
+    return value;
+}
+
+// maps whole file for reading, returns nullptr if it can't
+static const char* mapFile(const std::string& filename, std::size_t& size) {
+    int file = open(filename.c_str(), O_RDONLY);
+    if (file == -1) {
+        return nullptr;
+    }
+    struct stat fileStat{};
+    void* data = MAP_FAILED;
+    if (fstat(file, &fileStat) == 0 && fileStat.st_size > 0) {
+        size = static_cast<std::size_t>(fileStat.st_size);
+        data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+    }
+    close(file);
+    return data != MAP_FAILED ? static_cast<const char*>(data) : nullptr;
+}
+
+static void readRaw(const char*& position, const char* end, void* data, std::size_t size) {
+    if (static_cast<std::size_t>(end - position) < size) {
+        throw std::runtime_error("unexpected end of file");
+    }
+    std::memcpy(data, position, size);
+    position += size;
+}
+
+// array is written as its size and raw items
+template<typename T>
+static void readArray(const char*& position, const char* end, std::vector<T>& array) {
+    std::uint64_t size = 0;
+    readRaw(position, end, &size, sizeof(size));
+    if (size > static_cast<std::uint64_t>(end - position) / sizeof(T)) {
+        throw std::runtime_error("unexpected end of file");
+    }
+    array.resize(size);
+    readRaw(position, end, array.data(), size * sizeof(T));
+}
+
+static void writeRaw(std::ostream& os, const void* data, std::size_t size) {
+    os.write(static_cast<const char*>(data), size);
+}
+
+template<typename T>
+static void writeArray(std::ostream& os, const std::vector<T>& array) {
+    std::uint64_t size = array.size();
+    writeRaw(os, &size, sizeof(size));
+    writeRaw(os, array.data(), array.size() * sizeof(T));
+}
+
+MeshCache::MeshCache(const std::string& folder, const std::string& meshFilename, double units)
+: _folder(folder), _key(0), _units(units) {
+    std::size_t size = 0;
+    const char* data = mapFile(meshFilename, size);
+    if (data == nullptr) {
+        throw std::runtime_error("can't read mesh file: " + meshFilename);
+    }
+    _key = hash(data, size);
+    _key = hash(reinterpret_cast<const char*>(&units), sizeof(units), _key);
+    munmap(const_cast<char*>(data), size);
+}
+
+Mesh* MeshCache::read() const {
+    std::size_t size = 0;
+    const char* data = mapFile(getFilename(), size);
+    if (data == nullptr) {
+        return nullptr;
+    }
+
+    // file of other mesh, units or version is ignored
+    const char* position = data;
+    const char* end = data + size;
+    MeshCacheHeader header{};
+    Mesh* mesh = nullptr;
+    try {
+        readRaw(position, end, &header, sizeof(header));
+        if (std::equal(SIGNATURE, SIGNATURE + sizeof(SIGNATURE), header.signature) == true &&
+            header.key == _key && header.units == _units) {
+            mesh = new Mesh();
+
+            // physical entities are dimensions, ids and names one after another
+            std::vector<int> dimensions;
+            std::vector<int> ids;
+            std::vector<int> namesSizes;
+            std::vector<char> names;
+            readArray(position, end, dimensions);
+            readArray(position, end, ids);
+            readArray(position, end, namesSizes);
+            readArray(position, end, names);
+            std::size_t nameOffset = 0;
+            for (std::size_t i = 0; i < ids.size() && i < dimensions.size() && i < namesSizes.size(); i++) {
+                if (nameOffset + namesSizes[i] > names.size()) {
+                    throw std::runtime_error("wrong name size");
+                }
+                mesh->addPhysicalEntity(dimensions[i], ids[i], std::string(names.data() + nameOffset, namesSizes[i]));
+                nameOffset += namesSizes[i];
+            }
+
+            // flat arrays of mesh are stored as they are
+            readArray(position, end, mesh->_nodeIds);
+            readArray(position, end, mesh->_nodeCoordinates);
+
+            readArray(position, end, mesh->_elementIds);
+            readArray(position, end, mesh->_elementTypes);
+            readArray(position, end, mesh->_physicalEntityIds);
+            readArray(position, end, mesh->_geomUnitIds);
+            readArray(position, end, mesh->_processIds);
+            readArray(position, end, mesh->_nodesOffsets);
+            readArray(position, end, mesh->_elementNodes);
+            readArray(position, end, mesh->_volumes);
+
+            readArray(position, end, mesh->_sidesOffsets);
+            readArray(position, end, mesh->_sideTypes);
+            readArray(position, end, mesh->_sideNodesOffsets);
+            readArray(position, end, mesh->_sideNodes);
+            readArray(position, end, mesh->_sideNormals);
+            readArray(position, end, mesh->_sideVolumes);
+            readArray(position, end, mesh->_sideNeighborIds);
+
+            auto elementsSize = mesh->_elementIds.size();
+            auto sidesSize = mesh->_sideTypes.size();
+            if (mesh->_nodeCoordinates.size() != mesh->_nodeIds.size() * 3 ||
+                mesh->_elementTypes.size() != elementsSize || mesh->_physicalEntityIds.size() != elementsSize ||
+                mesh->_geomUnitIds.size() != elementsSize || mesh->_processIds.size() != elementsSize ||
+                mesh->_volumes.size() != elementsSize || mesh->_nodesOffsets.size() != elementsSize + 1 ||
+                mesh->_sidesOffsets.size() != elementsSize + 1 || mesh->_sideNodesOffsets.size() != sidesSize + 1 ||
+                mesh->_sideNormals.size() != sidesSize * 3 || mesh->_sideVolumes.size() != sidesSize ||
+                mesh->_sideNeighborIds.size() != sidesSize) {
+                throw std::runtime_error("wrong arrays sizes");
+            }
+            mesh->resetMaps();
+        }
+    } catch (std::exception& e) {
+        std::cout << "Broken mesh cache: " << getFilename() << std::endl;
+        delete mesh;
+        mesh = nullptr;
+    }
+    munmap(const_cast<char*>(data), size);
+    return mesh;
+}
+
+void MeshCache::write(Mesh* mesh) const {
+    create_directories(_folder);
+
+    MeshCacheHeader header{};
+    std::copy(SIGNATURE, SIGNATURE + sizeof(SIGNATURE), header.signature);
+    header.key = _key;
+    header.units = _units;
+
+    // written to temporary file first, so other run never reads incomplete cache
+    path filePath{getFilename()};
+    path tempPath{filePath.generic_string() + "." + std::to_string(getpid()) + ".tmp"};
+    std::ofstream fs(tempPath.generic_string(), std::ios::out | std::ios::binary);
+    writeRaw(fs, &header, sizeof(header));
+
+    std::vector<int> dimensions;
+    std::vector<int> ids;
+    std::vector<int> namesSizes;
+    std::vector<char> names;
+    for (const auto& entity : mesh->getPhysicalEntities()) {
+        dimensions.push_back(entity.getDimension());
+        ids.push_back(entity.getId());
+        namesSizes.push_back(static_cast<int>(entity.getName().size()));
+        names.insert(names.end(), entity.getName().begin(), entity.getName().end());
+    }
+    writeArray(fs, dimensions);
+    writeArray(fs, ids);
+    writeArray(fs, namesSizes);
+    writeArray(fs, names);
+
+    writeArray(fs, mesh->_nodeIds);
+    writeArray(fs, mesh->_nodeCoordinates);
+
+    writeArray(fs, mesh->_elementIds);
+    writeArray(fs, mesh->_elementTypes);
+    writeArray(fs, mesh->_physicalEntityIds);
+    writeArray(fs, mesh->_geomUnitIds);
+    writeArray(fs, mesh->_processIds);
+    writeArray(fs, mesh->_nodesOffsets);
+    writeArray(fs, mesh->_elementNodes);
+    writeArray(fs, mesh->_volumes);
+
+    writeArray(fs, mesh->_sidesOffsets);
+    writeArray(fs, mesh->_sideTypes);
+    writeArray(fs, mesh->_sideNodesOffsets);
+    writeArray(fs, mesh->_sideNodes);
+    writeArray(fs, mesh->_sideNormals);
+    writeArray(fs, mesh->_sideVolumes);
+    writeArray(fs, mesh->_sideNeighborIds);
+    fs.close();
+
+    if (fs.fail()) {
+        std::cout << "Can't write mesh cache: " << tempPath.generic_string() << std::endl;
+        remove(tempPath);
+        return;
+    }
+    rename(tempPath, filePath);
+}
+
+std::string MeshCache::getFilename() const {
+    std::ostringstream name;
+    name << std::hex << std::setw(16) << std::setfill('0') << _key << ".bin";
+    return (path(_folder) / name.str()).generic_string();
+}
@@ -0,0 +1,30 @@
+#ifndef RGS_MESHCACHE_H
+#define RGS_MESHCACHE_H
+
+#include <string>
+#include <cstdint>
+
+class Mesh;
+
+// keeps preprocessed mesh (flat arrays with sides, normals, volumes and neighbors) in binary file;
+// cached mesh is found by hash of mesh file and mesh units, so changed mesh is preprocessed again
+class MeshCache {
+private:
+    std::string _folder;
+    std::uint64_t _key;
+    double _units;
+
+public:
+    MeshCache(const std::string& folder, const std::string& meshFilename, double units);
+
+    Mesh* read() const;
+
+    void write(Mesh* mesh) const;
+
+private:
+    std::string getFilename() const;
+
+};
+
+
+#endif //RGS_MESHCACHE_H
@@ -1,146 +1,719 @@
 #include "MeshParser.h"
+#include "utilities/Utils.h"
 
-#include <fstream>
-#include <sstream>
 #include <iostream>
 #include <stdexcept>
+#include <cstring>
+#include <cstdlib>
+#include <thread>
+#include <algorithm>
+#include <cstdint>
+#include <cmath>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 using namespace std;
 
-MeshParser::MeshParser() {
-    _type = Type::UNDEFINED;
+// scanning of mapped text: no copies of lines, numbers are read in place
+
+static bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static void skipSpaces(const char*& position, const char* end) {
+    while (position != end && isSpace(*position)) {
+        position++;
+    }
+}
+
+static bool isLineEnd(const char*& position, const char* end) {
+    skipSpaces(position, end);
+    return position == end || *position == '\n';
+}
+
+static void nextLine(const char*& position, const char* end) {
+    auto lineEnd = static_cast<const char*>(std::memchr(position, '\n', end - position));
+    position = lineEnd != nullptr ? lineEnd + 1 : end;
+}
+
+// skips spaces and line ends, values of version 4 may continue on next line
+static void skipBlanks(const char*& position, const char* end) {
+    while (position != end && (isSpace(*position) || *position == '\n')) {
+        position++;
+    }
+}
+
+static const char* skipLines(const char* position, const char* end, std::size_t count) {
+    for (std::size_t i = 0; i < count && position != end; i++) {
+        nextLine(position, end);
+    }
+    return position;
+}
+
+static long readLong(const char*& position, const char* end) {
+    skipSpaces(position, end);
+    bool isNegative = false;
+    if (position != end && (*position == '-' || *position == '+')) {
+        isNegative = *position == '-';
+        position++;
+    }
+    if (position == end || *position < '0' || *position > '9') {
+        throw runtime_error("integer expected");
+    }
+    long value = 0;
+    while (position != end && *position >= '0' && *position <= '9') {
+        value = value * 10 + (*position - '0');
+        position++;
+    }
+    return isNegative ? -value : value;
+}
+
+static int readInt(const char*& position, const char* end) {
+    return static_cast<int>(readLong(position, end));
+}
+
+static double readDouble(const char*& position, const char* end) {
+    skipSpaces(position, end);
+
+    // mapped file isn't null-terminated, so number is copied to small buffer for strtod
+    char buffer[64];
+    std::size_t size = 0;
+    while (position != end && size < sizeof(buffer) - 1 && isSpace(*position) == false && *position != '\n') {
+        buffer[size++] = *position++;
+    }
+    buffer[size] = '\0';
+
+    char* bufferEnd;
+    double value = std::strtod(buffer, &bufferEnd);
+    if (size == 0 || bufferEnd != buffer + size) {
+        throw runtime_error("number expected");
+    }
+    return value;
+}
+
+template<class T>
+static T readBinary(const char*& position, const char* end) {
+    if (end - position < static_cast<std::ptrdiff_t>(sizeof(T))) {
+        throw runtime_error("unexpected end of binary data");
+    }
+    T value;
+    std::memcpy(&value, position, sizeof(T));
+    position += sizeof(T);
+    return value;
+}
+
+// parallel parsing isn't worth it for smaller chunks
+static const std::size_t MIN_CHUNK_SIZE = 1 << 20;
 
+MeshParser::MeshParser() {
     _keywords[Type::MESH_FORMAT] = "MeshFormat";
     _keywords[Type::PHYSICAL_NAMES] = "PhysicalNames";
+    _keywords[Type::ENTITIES] = "Entities";
+    _keywords[Type::PARTITIONED_ENTITIES] = "PartitionedEntities";
     _keywords[Type::NODES] =  "Nodes";
     _keywords[Type::ELEMENTS] = "Elements";
 
     _mesh = nullptr;
-
-    _isPhysicalEntitiesSizeLine = true;
-    _isNodesSizeLine = true;
-    _isElementsSizeLine = true;
+    _version = 0.0f;
+    _dataType = 0;
+    _fileSize = 0;
 }
 
 Mesh *MeshParser::loadMesh(const string &filename, double units) {
-    std::ifstream fs(filename);
-    if (fs.is_open() == true) {
-        _mesh = new Mesh();
+    int file = open(filename.c_str(), O_RDONLY);
+    if (file == -1) {
+        return nullptr;
+    }
 
-        try {
-            string line;
-            while (getline(fs, line)) {
-                line = line.substr(0, line.size() - 1);
-                parse(line, units);
-            }
-            fs.close();
+    // whole file is mapped to memory and parsed in place
+    struct stat fileStat{};
+    if (fstat(file, &fileStat) == -1) {
+        close(file);
+        throw std::runtime_error("parsing error: can't read size of " + filename);
+    }
+    auto size = static_cast<std::size_t>(fileStat.st_size);
+    void* data = nullptr;
+    if (size > 0) {
+        data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+    }
+    close(file);
+    if (data == MAP_FAILED) {
+        throw std::runtime_error("parsing error: can't map " + filename);
+    }
+    if (data != nullptr) {
+        madvise(data, size, MADV_SEQUENTIAL);
+    }
 
-            cout << "Successful mesh parsing: version = " << _version << "; type = " << _dataType << "; size = " << _fileSize << endl;
-        } catch (std::exception& e) {
-            delete _mesh;
-            _mesh = nullptr;
+    _mesh = new Mesh();
+    _version = 0.0f;
+    _dataType = 0;
+    _fileSize = 0;
+    _entities.clear();
+    try {
+        auto begin = static_cast<const char*>(data);
+        parse(begin, begin + size, units);
 
-            throw std::runtime_error(std::string("parsing error: ") + e.what());
+        cout << "Successful mesh parsing: version = " << _version << "; type = " << _dataType << "; size = " << _fileSize << endl;
+    } catch (std::exception& e) {
+        delete _mesh;
+        _mesh = nullptr;
+        if (data != nullptr) {
+            munmap(data, size);
         }
+
+        throw std::runtime_error(std::string("parsing error: ") + e.what());
+    }
+    if (data != nullptr) {
+        munmap(data, size);
     }
     return _mesh;
 }
 
-void MeshParser::parse(const string& line, double units) {
-    if (line.empty() == false) {
-        if (line[0] == '$') { // it is directive
-            if (_type == Type::UNDEFINED) {
-                for (auto const& keyword : _keywords) {
-                    if (line.find(keyword.second) != string::npos) {
-                        _type = keyword.first;
-                        break;
-                    }
-                }
+void MeshParser::parse(const char* begin, const char* end, double units) {
+    const char* position = begin;
+    while (position != end) {
+        if (isLineEnd(position, end)) {
+            nextLine(position, end);
+            continue;
+        }
+        if (*position != '$') {
+            throw runtime_error("missing directive");
+        }
+
+        // directive name
+        const char* nameBegin = ++position;
+        while (position != end && isSpace(*position) == false && *position != '\n') {
+            position++;
+        }
+        std::string name(nameBegin, position);
+        if (name.compare(0, 3, "End") == 0) {
+            throw runtime_error("wrong directive order");
+        }
+        nextLine(position, end);
+        std::string endDirective = "$End" + name;
+
+        // version 4 sections are read sequentially, binary data can't be searched for end directive
+        if (_version >= 4.0f && (name == _keywords[Type::ENTITIES] || name == _keywords[Type::PARTITIONED_ENTITIES] ||
+                                 name == _keywords[Type::NODES] || name == _keywords[Type::ELEMENTS])) {
+            if (name == _keywords[Type::ENTITIES]) {
+                parseEntities(position, end, false);
+            } else if (name == _keywords[Type::PARTITIONED_ENTITIES]) {
+                parseEntities(position, end, true);
+            } else if (name == _keywords[Type::NODES]) {
+                parseNodes4(position, end, units);
             } else {
-                if (line.find(_keywords[_type]) != string::npos && line.find("End") != string::npos) {
-                    _type = Type::UNDEFINED;
-                } else {
-                    throw runtime_error("wrong directive order");
+                parseElements4(position, end);
+            }
+            skipBlanks(position, end);
+            if (static_cast<std::size_t>(end - position) < endDirective.size() ||
+                std::equal(endDirective.begin(), endDirective.end(), position) == false) {
+                throw runtime_error("no directive " + endDirective);
+            }
+            nextLine(position, end);
+            continue;
+        }
+
+        // section lasts till its end directive at line start
+        const char* sectionEnd = position;
+        while (true) {
+            sectionEnd = std::search(sectionEnd, end, endDirective.begin(), endDirective.end());
+            if (sectionEnd == end) {
+                throw runtime_error("no directive " + endDirective);
+            }
+            if (sectionEnd == begin || sectionEnd[-1] == '\n') {
+                break;
+            }
+            sectionEnd++;
+        }
+        Section section{position, sectionEnd};
+
+        if (name == _keywords[Type::MESH_FORMAT]) {
+            parseMeshFormat(section);
+        } else if (name == _keywords[Type::PHYSICAL_NAMES]) {
+            parsePhysicalNames(section);
+        } else if (name == _keywords[Type::NODES]) {
+            parseNodes(section, units);
+        } else if (name == _keywords[Type::ELEMENTS]) {
+            parseElements(section);
+        }
+
+        // other sections are skipped
+        position = sectionEnd;
+        nextLine(position, end);
+    }
+}
+
+void MeshParser::parseMeshFormat(const Section& section) {
+    const char* position = section.begin;
+    _version = static_cast<float>(readDouble(position, section.end));
+    _dataType = readInt(position, section.end);
+    _fileSize = readInt(position, section.end);
+
+    if (_version >= 2.0f && _version < 3.0f) {
+        if (_dataType != 0) {
+            throw runtime_error("binary format is supported for version 4.1 only");
+        }
+    } else if (std::abs(_version - 4.1f) < 1e-6f) {
+        if (isBinary() == true) {
+            if (_fileSize != sizeof(std::size_t)) {
+                throw runtime_error("unsupported data size " + std::to_string(_fileSize));
+            }
+
+            // binary one written by gmsh shows byte order
+            nextLine(position, section.end);
+            if (readBinary<int32_t>(position, section.end) != 1) {
+                throw runtime_error("byte order of binary file differs");
+            }
+        }
+    } else {
+        throw runtime_error("unsupported version " + std::to_string(_version));
+    }
+}
+
+void MeshParser::parsePhysicalNames(const Section& section) {
+    const char* position = section.begin;
+    auto size = static_cast<std::size_t>(readInt(position, section.end));
+    nextLine(position, section.end);
+    _mesh->reservePhysicalEntities(size);
+
+    for (std::size_t i = 0; i < size; i++) {
+        int dimension = readInt(position, section.end);
+        int tag = readInt(position, section.end);
+
+        // name is rest of line without quotes
+        skipSpaces(position, section.end);
+        const char* nameBegin = position;
+        nextLine(position, section.end);
+        const char* nameEnd = position;
+        while (nameEnd != nameBegin && (nameEnd[-1] == '\n' || isSpace(nameEnd[-1]))) {
+            nameEnd--;
+        }
+        if (nameEnd - nameBegin >= 2 && nameBegin[0] == '\"' && nameEnd[-1] == '\"') {
+            nameBegin++;
+            nameEnd--;
+        }
+        _mesh->addPhysicalEntity(dimension, tag, std::string(nameBegin, nameEnd));
+    }
+}
+
+void MeshParser::parseNodes(const Section& section, double units) {
+    const char* position = section.begin;
+    auto size = static_cast<std::size_t>(readInt(position, section.end));
+    nextLine(position, section.end);
+    _mesh->reserveNodes(size);
+
+    // chunks are parsed in parallel, then nodes are added in file order
+    auto chunks = splitSection({position, section.end});
+    std::vector<std::vector<int>> ids(chunks.size());
+    std::vector<std::vector<Vector3d>> positions(chunks.size());
+    Utils::forEachChunk(chunks.size(), [&](std::size_t ci) {
+        const char* chunkPosition = chunks[ci].begin;
+        const char* chunkEnd = chunks[ci].end;
+        while (chunkPosition != chunkEnd) {
+            if (isLineEnd(chunkPosition, chunkEnd) == false) {
+                ids[ci].push_back(readInt(chunkPosition, chunkEnd));
+                double x = readDouble(chunkPosition, chunkEnd);
+                double y = readDouble(chunkPosition, chunkEnd);
+                double z = readDouble(chunkPosition, chunkEnd);
+                positions[ci].emplace_back(x * units, y * units, z * units);
+            }
+            nextLine(chunkPosition, chunkEnd);
+        }
+    });
+
+    std::size_t parsedSize = 0;
+    for (std::size_t ci = 0; ci < chunks.size(); ci++) {
+        for (std::size_t i = 0; i < ids[ci].size(); i++) {
+            _mesh->addNode(ids[ci][i], positions[ci][i]);
+        }
+        parsedSize += ids[ci].size();
+    }
+    if (parsedSize != size) {
+        throw runtime_error("wrong number of nodes: " + std::to_string(parsedSize) + " instead of " + std::to_string(size));
+    }
+}
+
+void MeshParser::parseElements(const Section& section) {
+    const char* position = section.begin;
+    auto size = static_cast<std::size_t>(readInt(position, section.end));
+    nextLine(position, section.end);
+    _mesh->reserveElements(size);
+
+    // each element is flattened to: id, type, physical entity, geom unit, partitions size, partitions, nodes size, nodes
+    auto chunks = splitSection({position, section.end});
+    std::vector<std::vector<int>> records(chunks.size());
+    Utils::forEachChunk(chunks.size(), [&](std::size_t ci) {
+        const char* chunkPosition = chunks[ci].begin;
+        const char* chunkEnd = chunks[ci].end;
+        auto& record = records[ci];
+        while (chunkPosition != chunkEnd) {
+            if (isLineEnd(chunkPosition, chunkEnd) == false) {
+                record.push_back(readInt(chunkPosition, chunkEnd));
+                record.push_back(readInt(chunkPosition, chunkEnd));
+
+                // tags: physical entity, geom unit, partitions size, partitions
+                int tagsCount = readInt(chunkPosition, chunkEnd);
+                int physicalEntityId = tagsCount > 0 ? readInt(chunkPosition, chunkEnd) : 0;
+                int geomUnitId = tagsCount > 1 ? readInt(chunkPosition, chunkEnd) : 0;
+                if (tagsCount > 2) {
+                    readInt(chunkPosition, chunkEnd);
+                }
+                record.push_back(physicalEntityId);
+                record.push_back(geomUnitId);
+                record.push_back(std::max(tagsCount - 3, 0));
+                for (int i = 3; i < tagsCount; i++) {
+                    record.push_back(readInt(chunkPosition, chunkEnd));
+                }
+
+                // nodes are the rest of line
+                std::size_t nodesSizeIndex = record.size();
+                record.push_back(0);
+                while (isLineEnd(chunkPosition, chunkEnd) == false) {
+                    record.push_back(readInt(chunkPosition, chunkEnd));
+                    record[nodesSizeIndex]++;
                 }
             }
-        } else { // it is usual data
-            std::istringstream is(line);
-            switch (_type) {
-                case Type::UNDEFINED:
-                    throw runtime_error("missing directive");
-                case Type::MESH_FORMAT:
-                    is >> _version >> _dataType >> _fileSize;
-                    break;
-                case Type::PHYSICAL_NAMES:
-                    if (_isPhysicalEntitiesSizeLine) {
-                        _isPhysicalEntitiesSizeLine = false;
-
-                        size_t capacity;
-                        is >> capacity;
-                        _mesh->reservePhysicalEntities(capacity);
-                    } else {
-                        int dimension, tag;
-                        std::string name;
-                        is >> dimension >> tag >> name;
-                        if (name[0] == '\"') {
-                            name.erase(0, 1);
-                            name.erase(name.size() - 1);
-                        }
-                        _mesh->addPhysicalEntity(dimension, tag, name);
+            nextLine(chunkPosition, chunkEnd);
+        }
+    });
+
+    std::size_t parsedSize = addElements(records);
+    if (parsedSize != size) {
+        throw runtime_error("wrong number of elements: " + std::to_string(parsedSize) + " instead of " + std::to_string(size));
+    }
+}
+
+void MeshParser::parseEntities(const char*& position, const char* end, bool isPartitioned) {
+
+    // ghost entities aren't needed, each process gets its halo from whole mesh
+    if (isPartitioned == true) {
+        readSize(position, end);
+        auto ghostsSize = readSize(position, end);
+        for (std::size_t i = 0; i < ghostsSize; i++) {
+            readTag(position, end);
+            readTag(position, end);
+        }
+    }
+
+    std::size_t sizes[4];
+    for (auto& size : sizes) {
+        size = readSize(position, end);
+    }
+    for (int dimension = 0; dimension < 4; dimension++) {
+        for (std::size_t i = 0; i < sizes[dimension]; i++) {
+            int tag = readTag(position, end);
+            Entity entity{0, tag, {}};
+
+            // partitioned entity keeps tag of original one as geom unit
+            const Entity* parent = nullptr;
+            if (isPartitioned == true) {
+                int parentDimension = readTag(position, end);
+                int parentTag = readTag(position, end);
+                auto parentIt = _entities.find(std::make_pair(parentDimension, parentTag));
+                if (parentIt != _entities.end()) {
+                    parent = &parentIt->second;
+                }
+                entity.geomUnitId = parentTag;
+
+                auto partitionsSize = readSize(position, end);
+                for (std::size_t pi = 0; pi < partitionsSize; pi++) {
+                    entity.partitions.push_back(readTag(position, end));
+                }
+            }
+
+            // point has coordinates, other entities have bounding box
+            for (int ci = 0; ci < (dimension == 0 ? 3 : 6); ci++) {
+                readCoordinate(position, end);
+            }
+
+            auto physicalsSize = readSize(position, end);
+            for (std::size_t pi = 0; pi < physicalsSize; pi++) {
+                int physicalEntityId = readTag(position, end);
+                if (pi == 0) {
+                    entity.physicalEntityId = physicalEntityId;
+                }
+            }
+            if (physicalsSize == 0 && parent != nullptr) {
+                entity.physicalEntityId = parent->physicalEntityId;
+            }
+
+            if (dimension > 0) {
+                auto boundsSize = readSize(position, end);
+                for (std::size_t bi = 0; bi < boundsSize; bi++) {
+                    readTag(position, end);
+                }
+            }
+
+            _entities[std::make_pair(dimension, tag)] = entity;
+        }
+    }
+}
+
+void MeshParser::parseNodes4(const char*& position, const char* end, double units) {
+    auto blocksSize = readSize(position, end);
+    auto size = readSize(position, end);
+    readSize(position, end);
+    readSize(position, end);
+    _mesh->reserveNodes(size);
+
+    std::size_t parsedSize = 0;
+    std::vector<int> ids;
+    std::vector<Vector3d> positions;
+    for (std::size_t bi = 0; bi < blocksSize; bi++) {
+        int dimension = readTag(position, end);
+        readTag(position, end);
+        int isParametric = readTag(position, end);
+        auto blockSize = readSize(position, end);
+
+        // block has tags of all nodes first, then their coordinates
+        ids.resize(blockSize);
+        for (auto& id : ids) {
+            id = static_cast<int>(readSize(position, end));
+        }
+
+        positions.clear();
+        if (isBinary() == true) {
+            for (std::size_t i = 0; i < blockSize; i++) {
+                double x = readBinary<double>(position, end);
+                double y = readBinary<double>(position, end);
+                double z = readBinary<double>(position, end);
+                positions.emplace_back(x * units, y * units, z * units);
+                for (int ui = 0; isParametric != 0 && ui < dimension; ui++) {
+                    readBinary<double>(position, end);
+                }
+            }
+        } else {
+
+            // one line per node, lines are parsed in parallel chunks
+            skipBlanks(position, end);
+            const char* blockBegin = position;
+            position = skipLines(position, end, blockSize);
+            auto chunks = splitSection({blockBegin, position});
+            std::vector<std::vector<Vector3d>> chunkPositions(chunks.size());
+            Utils::forEachChunk(chunks.size(), [&](std::size_t ci) {
+                const char* chunkPosition = chunks[ci].begin;
+                const char* chunkEnd = chunks[ci].end;
+                while (chunkPosition != chunkEnd) {
+                    if (isLineEnd(chunkPosition, chunkEnd) == false) {
+                        double x = readDouble(chunkPosition, chunkEnd);
+                        double y = readDouble(chunkPosition, chunkEnd);
+                        double z = readDouble(chunkPosition, chunkEnd);
+                        chunkPositions[ci].emplace_back(x * units, y * units, z * units);
                     }
-                    break;
-                case Type::NODES:
-                    if (_isNodesSizeLine) {
-                        _isNodesSizeLine = false;
-
-                        size_t capacity;
-                        is >> capacity;
-                        _mesh->reserveNodes(capacity);
-                    } else {
-                        int id;
-                        double x, y, z;
-                        is >> id >> x >> y >> z;
-                        x *= units;
-                        y *= units;
-                        z *= units;
-                        _mesh->addNode(id, Vector3d(x, y, z));
+                    nextLine(chunkPosition, chunkEnd);
+                }
+            });
+            for (const auto& chunk : chunkPositions) {
+                positions.insert(positions.end(), chunk.begin(), chunk.end());
+            }
+            if (positions.size() != blockSize) {
+                throw runtime_error("wrong number of node coordinates in block " + std::to_string(bi));
+            }
+        }
+
+        for (std::size_t i = 0; i < blockSize; i++) {
+            _mesh->addNode(ids[i], positions[i]);
+        }
+        parsedSize += blockSize;
+    }
+    if (parsedSize != size) {
+        throw runtime_error("wrong number of nodes: " + std::to_string(parsedSize) + " instead of " + std::to_string(size));
+    }
+}
+
+void MeshParser::parseElements4(const char*& position, const char* end) {
+    auto blocksSize = readSize(position, end);
+    auto size = readSize(position, end);
+    readSize(position, end);
+    readSize(position, end);
+    _mesh->reserveElements(size);
+
+    std::size_t parsedSize = 0;
+    for (std::size_t bi = 0; bi < blocksSize; bi++) {
+        int dimension = readTag(position, end);
+        int entityTag = readTag(position, end);
+        int type = readTag(position, end);
+        auto blockSize = readSize(position, end);
+
+        // tags of all elements in block come from their entity
+        Entity entity{0, entityTag, {}};
+        auto entityIt = _entities.find(std::make_pair(dimension, entityTag));
+        if (entityIt != _entities.end()) {
+            entity = entityIt->second;
+        }
+        auto addTags = [type, &entity](std::vector<int>& record) {
+            record.push_back(type);
+            record.push_back(entity.physicalEntityId);
+            record.push_back(entity.geomUnitId);
+            record.push_back(static_cast<int>(entity.partitions.size()));
+            record.insert(record.end(), entity.partitions.begin(), entity.partitions.end());
+        };
+
+        std::vector<std::vector<int>> records;
+        if (isBinary() == true) {
+
+            // each element is its tag and node tags
+            auto nodesSize = static_cast<std::size_t>(getNodesSize(type));
+            auto elementSize = (1 + nodesSize) * sizeof(std::size_t);
+            if (static_cast<std::size_t>(end - position) < blockSize * elementSize) {
+                throw runtime_error("unexpected end of binary data");
+            }
+            const char* blockBegin = position;
+            position += blockSize * elementSize;
+
+            auto chunksSize = getChunksSize(blockSize * elementSize);
+            records.resize(chunksSize);
+            Utils::forEachChunk(chunksSize, [&](std::size_t ci) {
+                const char* chunkPosition = blockBegin + blockSize * ci / chunksSize * elementSize;
+                const char* chunkEnd = blockBegin + blockSize * (ci + 1) / chunksSize * elementSize;
+                auto& record = records[ci];
+                while (chunkPosition != chunkEnd) {
+                    record.push_back(static_cast<int>(readBinary<std::size_t>(chunkPosition, chunkEnd)));
+                    addTags(record);
+                    record.push_back(static_cast<int>(nodesSize));
+                    for (std::size_t ni = 0; ni < nodesSize; ni++) {
+                        record.push_back(static_cast<int>(readBinary<std::size_t>(chunkPosition, chunkEnd)));
                     }
-                    break;
-                case Type::ELEMENTS:
-                    if (_isElementsSizeLine) {
-                        _isElementsSizeLine = false;
-
-                        size_t capacity;
-                        is >> capacity;
-                        _mesh->reserveElements(capacity);
-                    } else {
-                        int id, type, tagsCount;
-                        is >> id >> type >> tagsCount;
-                        vector<int> tags;
-                        for (int i = 0; i < tagsCount; i++) {
-                            int tag;
-                            is >> tag;
-                            tags.push_back(tag);
-                        }
-                        int physicalEntityId = tags[0];
-                        int geomUnitId = tags[1];
-                        vector<int> partitions;
-                        for (auto i = 3; i < tags.size(); i++) {
-                            partitions.push_back(tags[i]);
-                        }
+                }
+            });
+        } else {
 
-                        vector<int> nodeIds;
-                        do {
-                            int nodeId;
-                            is >> nodeId;
-                            nodeIds.push_back(nodeId);
-                        } while (is.good());
+            // one line per element, nodes are the rest of line
+            skipBlanks(position, end);
+            const char* blockBegin = position;
+            position = skipLines(position, end, blockSize);
+            auto chunks = splitSection({blockBegin, position});
+            records.resize(chunks.size());
+            Utils::forEachChunk(chunks.size(), [&](std::size_t ci) {
+                const char* chunkPosition = chunks[ci].begin;
+                const char* chunkEnd = chunks[ci].end;
+                auto& record = records[ci];
+                while (chunkPosition != chunkEnd) {
+                    if (isLineEnd(chunkPosition, chunkEnd) == false) {
+                        record.push_back(static_cast<int>(readLong(chunkPosition, chunkEnd)));
+                        addTags(record);
 
-                        _mesh->addElement(id, type, physicalEntityId, geomUnitId, partitions, nodeIds);
+                        std::size_t nodesSizeIndex = record.size();
+                        record.push_back(0);
+                        while (isLineEnd(chunkPosition, chunkEnd) == false) {
+                            record.push_back(static_cast<int>(readLong(chunkPosition, chunkEnd)));
+                            record[nodesSizeIndex]++;
+                        }
                     }
-                    break;
-            }
+                    nextLine(chunkPosition, chunkEnd);
+                }
+            });
         }
+
+        auto addedSize = addElements(records);
+        if (addedSize != blockSize) {
+            throw runtime_error("wrong number of elements in block " + std::to_string(bi));
+        }
+        parsedSize += addedSize;
+    }
+    if (parsedSize != size) {
+        throw runtime_error("wrong number of elements: " + std::to_string(parsedSize) + " instead of " + std::to_string(size));
     }
 }
 
+std::size_t MeshParser::addElements(const std::vector<std::vector<int>>& records) {
+    std::size_t size = 0;
+    std::vector<int> partitions;
+    std::vector<int> nodeIds;
+    for (const auto& record : records) {
+        auto it = record.begin();
+        while (it != record.end()) {
+            int id = *it++;
+            int type = *it++;
+            int physicalEntityId = *it++;
+            int geomUnitId = *it++;
+            int partitionsSize = *it++;
+            partitions.assign(it, it + partitionsSize);
+            it += partitionsSize;
+            int nodesSize = *it++;
+            nodeIds.assign(it, it + nodesSize);
+            it += nodesSize;
+
+            _mesh->addElement(id, type, physicalEntityId, geomUnitId, partitions, nodeIds);
+            size++;
+        }
+    }
+    return size;
+}
+
+bool MeshParser::isBinary() const {
+    return _dataType == 1;
+}
+
+int MeshParser::readTag(const char*& position, const char* end) const {
+    if (isBinary() == true) {
+        return readBinary<int32_t>(position, end);
+    }
+    skipBlanks(position, end);
+    return readInt(position, end);
+}
+
+std::size_t MeshParser::readSize(const char*& position, const char* end) const {
+    if (isBinary() == true) {
+        return readBinary<std::size_t>(position, end);
+    }
+    skipBlanks(position, end);
+    return static_cast<std::size_t>(readLong(position, end));
+}
+
+double MeshParser::readCoordinate(const char*& position, const char* end) const {
+    if (isBinary() == true) {
+        return readBinary<double>(position, end);
+    }
+    skipBlanks(position, end);
+    return readDouble(position, end);
+}
+
+std::vector<MeshParser::Section> MeshParser::splitSection(const Section& section) {
+    auto size = static_cast<std::size_t>(section.end - section.begin);
+    auto chunksSize = getChunksSize(size);
+
+    // chunk borders are moved to line starts
+    std::vector<Section> chunks;
+    const char* chunkBegin = section.begin;
+    for (std::size_t ci = 1; ci <= chunksSize; ci++) {
+        const char* chunkEnd = section.end;
+        if (ci < chunksSize) {
+            chunkEnd = std::max(chunkBegin, section.begin + size * ci / chunksSize);
+            nextLine(chunkEnd, section.end);
+        }
+        chunks.push_back({chunkBegin, chunkEnd});
+        chunkBegin = chunkEnd;
+    }
+    return chunks;
+}
+
+std::size_t MeshParser::getChunksSize(std::size_t size) {
+    std::size_t chunksSize = std::max(1u, std::thread::hardware_concurrency());
+    return std::max<std::size_t>(1, std::min(chunksSize, size / MIN_CHUNK_SIZE));
+}
+
+int MeshParser::getNodesSize(int type) {
+    switch (type) {
+        case 15: return 1; // point
+        case 1: return 2; // line
+        case 2: return 3; // triangle
+        case 3: return 4; // quadrangle
+        case 4: return 4; // tetrahedron
+        case 5: return 8; // hexahedron
+        case 6: return 6; // prism
+        case 7: return 5; // pyramid
+        case 8: return 3; // second order line
+        case 9: return 6; // second order triangle
+        case 10: return 9; // second order quadrangle
+        case 11: return 10; // second order tetrahedron
+        case 12: return 27; // second order hexahedron
+        case 13: return 18; // second order prism
+        case 14: return 14; // second order pyramid
+        default:
+            throw runtime_error("unknown element type " + std::to_string(type));
+    }
+}
@@ -4,6 +4,7 @@
 #include "Mesh.h"
 
 #include <map>
+#include <vector>
 
 class MeshParser {
 private:
@@ -11,15 +12,27 @@ private:
         UNDEFINED,
         MESH_FORMAT,
         PHYSICAL_NAMES,
+        ENTITIES,
+        PARTITIONED_ENTITIES,
         NODES,
         ELEMENTS
     };
 
+    // text of one section, pointers into mapped file
+    struct Section {
+        const char* begin;
+        const char* end;
+    };
+
+    // geometrical entity of version 4, elements of block get their tags from it
+    struct Entity {
+        int physicalEntityId;
+        int geomUnitId;
+        std::vector<int> partitions;
+    };
+
     std::map<Type, std::string> _keywords;
-    Type _type;
-    bool _isPhysicalEntitiesSizeLine;
-    bool _isNodesSizeLine;
-    bool _isElementsSizeLine;
+    std::map<std::pair<int, int>, Entity> _entities;
 
     Mesh* _mesh;
     float _version;
@@ -40,7 +53,40 @@ private:
     MeshParser();
     ~MeshParser() = default;
 
-    void parse(const std::string& line, double units);
+    void parse(const char* begin, const char* end, double units);
+
+    void parseMeshFormat(const Section& section);
+
+    void parsePhysicalNames(const Section& section);
+
+    void parseNodes(const Section& section, double units);
+
+    void parseElements(const Section& section);
+
+    // sections of version 4, position is moved to the end of section data
+    void parseEntities(const char*& position, const char* end, bool isPartitioned);
+
+    void parseNodes4(const char*& position, const char* end, double units);
+
+    void parseElements4(const char*& position, const char* end);
+
+    // elements are given by records: id, type, physical entity, geom unit, partitions size, partitions, nodes size, nodes
+    std::size_t addElements(const std::vector<std::vector<int>>& records);
+
+    bool isBinary() const;
+
+    int readTag(const char*& position, const char* end) const;
+
+    std::size_t readSize(const char*& position, const char* end) const;
+
+    double readCoordinate(const char*& position, const char* end) const;
+
+    // splits lines of section into chunks of about equal size
+    static std::vector<Section> splitSection(const Section& section);
+
+    static std::size_t getChunksSize(std::size_t size);
+
+    static int getNodesSize(int type);
 
 };
 
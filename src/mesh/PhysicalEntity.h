@@ -30,6 +30,14 @@ public:
         return _name;
     }
 
+    bool isMain() const {
+        return _name.find("Main") == 0;
+    }
+
+    bool isBorder() const {
+        return _name.find("Border") == 0;
+    }
+
 private:
     template<class Archive>
     void serialize(Archive & ar, const unsigned int version) {
@@ -2,63 +2,34 @@
 #define RGS_PRISM_H
 
 #include "Element.h"
-#include "Triangle.h"
-#include "Quadrangle.h"
-
-class Prism : public Element {
-    friend class boost::serialization::access;
 
+class Prism {
 public:
-    Prism() = default;
-
-    Prism(int id, int physicalEntityId, int geomUnitId, const std::vector<int>& partitions, const std::vector<int>& nodeIds)
-    : Element(Type::PRISM, id, physicalEntityId, geomUnitId, partitions, nodeIds) {}
-
-    explicit Prism(const std::vector<int>& nodeIds) : Prism(0, -1, -1, {}, nodeIds) {}
-
-private:
-    template<class Archive>
-    void serialize(Archive & ar, const unsigned int version) {
-        ar & boost::serialization::base_object<Element>(*this);
+    static double getVolume(const std::vector<Vector3d>& positions) {
+        Vector3d v10 = positions[1] - positions[0];
+        Vector3d v20 = positions[2] - positions[0];
+        Vector3d v30 = positions[3] - positions[0];
+        return v10.vector(v20).module() * v30.module() / 2;
     }
 
-    void innerInit(const std::vector<Node*>& nodes, bool isSideElementsRequired) override {
-        Vector3d v10 = nodes[1]->getPosition() - nodes[0]->getPosition();
-        Vector3d v20 = nodes[2]->getPosition() - nodes[0]->getPosition();
-        Vector3d v21 = nodes[2]->getPosition() - nodes[1]->getPosition();
-        Vector3d v30 = nodes[3]->getPosition() - nodes[0]->getPosition();
-        Vector3d v43 = nodes[4]->getPosition() - nodes[3]->getPosition();
-        Vector3d v53 = nodes[5]->getPosition() - nodes[3]->getPosition();
-
-        if (isSideElementsRequired) {
-            _sideElements.clear();
+    static void getSides(const std::vector<Vector3d>& positions, std::vector<Element::Side>& sides) {
+        Vector3d v10 = positions[1] - positions[0];
+        Vector3d v20 = positions[2] - positions[0];
+        Vector3d v21 = positions[2] - positions[1];
+        Vector3d v30 = positions[3] - positions[0];
+        Vector3d v43 = positions[4] - positions[3];
+        Vector3d v53 = positions[5] - positions[3];
 
-            // up and down sides
-            _sideElements.emplace_back(new SideElement(
-                    new Triangle({nodes[0]->getId(), nodes[1]->getId(), nodes[2]->getId()}),
-                    v20.vector(v10).normalize()
-            ));
-            _sideElements.emplace_back(new SideElement(
-                    new Triangle({nodes[3]->getId(), nodes[4]->getId(), nodes[5]->getId()}),
-                    v43.vector(v53).normalize()
-            ));
+        sides.clear();
 
-            // other sides
-            _sideElements.emplace_back(new SideElement(
-                    new Quadrangle({nodes[0]->getId(), nodes[1]->getId(), nodes[4]->getId(), nodes[3]->getId()}),
-                    v10.vector(v30).normalize()
-            ));
-            _sideElements.emplace_back(new SideElement(
-                    new Quadrangle({nodes[0]->getId(), nodes[2]->getId(), nodes[5]->getId(), nodes[3]->getId()}),
-                    v30.vector(v20).normalize()
-            ));
-            _sideElements.emplace_back(new SideElement(
-                    new Quadrangle({nodes[1]->getId(), nodes[2]->getId(), nodes[5]->getId(), nodes[4]->getId()}),
-                    v21.vector(v30).normalize()
-            ));
-        }
+        // up and down sides
+        sides.emplace_back(Element::Type::TRIANGLE, std::initializer_list<int>{0, 1, 2}, v20.vector(v10).normalize());
+        sides.emplace_back(Element::Type::TRIANGLE, std::initializer_list<int>{3, 4, 5}, v43.vector(v53).normalize());
 
-        _volume = v10.vector(v20).module() * v30.module() / 2;
+        // other sides
+        sides.emplace_back(Element::Type::QUADRANGLE, std::initializer_list<int>{0, 1, 4, 3}, v10.vector(v30).normalize());
+        sides.emplace_back(Element::Type::QUADRANGLE, std::initializer_list<int>{0, 2, 5, 3}, v30.vector(v20).normalize());
+        sides.emplace_back(Element::Type::QUADRANGLE, std::initializer_list<int>{1, 2, 5, 4}, v21.vector(v30).normalize());
     }
 
 };
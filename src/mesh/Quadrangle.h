@@ -2,48 +2,28 @@
 #define RGS_QUADRANGLE_H
 
 #include "Element.h"
-#include "Line.h"
-
-class Quadrangle : public Element {
-    friend class boost::serialization::access;
-
-private:
-    std::vector<std::shared_ptr<Line>> _diagonalElements;
 
+class Quadrangle {
 public:
-    Quadrangle() = default;
-
-    Quadrangle(int id, int physicalEntityId, int geomUnitId, const std::vector<int>& partitions, const std::vector<int>& nodeIds)
-    : Element(Type::QUADRANGLE, id, physicalEntityId, geomUnitId, partitions, nodeIds) {}
+    static double getVolume(const std::vector<Vector3d>& positions) {
 
-    explicit Quadrangle(const std::vector<int>& nodeIds) : Quadrangle(0, -1, -1, {}, nodeIds) {}
-
-private:
-    template<class Archive>
-    void serialize(Archive & ar, const unsigned int version) {
-        ar & boost::serialization::base_object<Element>(*this);
-        ar & _diagonalElements;
+        // volume is easy: d1d2sin(1,2) / 2
+        Vector3d diag1 = positions[2] - positions[0];
+        Vector3d diag2 = positions[3] - positions[1];
+        return diag1.vector(diag2).module() / 2;
     }
 
-    void innerInit(const std::vector<Node*>& nodes, bool isSideElementsRequired) override {
-        if (isSideElementsRequired) {
-            _sideElements.clear();
-
-            Vector3d a = nodes[1]->getPosition() - nodes[0]->getPosition();
-            Vector3d b = nodes[2]->getPosition() - nodes[1]->getPosition();
-            Vector3d c = nodes[3]->getPosition() - nodes[2]->getPosition();
-            Vector3d d = nodes[0]->getPosition() - nodes[3]->getPosition();
-
-            _sideElements.emplace_back(new SideElement(new Line({nodes[0]->getId(), nodes[1]->getId()}), -a.vector(b).vector(a).normalize()));
-            _sideElements.emplace_back(new SideElement(new Line({nodes[1]->getId(), nodes[2]->getId()}), -b.vector(c).vector(b).normalize()));
-            _sideElements.emplace_back(new SideElement(new Line({nodes[2]->getId(), nodes[3]->getId()}), -c.vector(d).vector(c).normalize()));
-            _sideElements.emplace_back(new SideElement(new Line({nodes[3]->getId(), nodes[0]->getId()}), -d.vector(a).vector(d).normalize()));
-        }
-
-        // volume is easy: d1d2sin(1,2) / 2
-        Vector3d diag1 = nodes[2]->getPosition() - nodes[0]->getPosition();
-        Vector3d diag2 = nodes[3]->getPosition() - nodes[1]->getPosition();
-        _volume = diag1.vector(diag2).module() / 2;
+    static void getSides(const std::vector<Vector3d>& positions, std::vector<Element::Side>& sides) {
+        Vector3d a = positions[1] - positions[0];
+        Vector3d b = positions[2] - positions[1];
+        Vector3d c = positions[3] - positions[2];
+        Vector3d d = positions[0] - positions[3];
+
+        sides.clear();
+        sides.emplace_back(Element::Type::LINE, std::initializer_list<int>{0, 1}, -a.vector(b).vector(a).normalize());
+        sides.emplace_back(Element::Type::LINE, std::initializer_list<int>{1, 2}, -b.vector(c).vector(b).normalize());
+        sides.emplace_back(Element::Type::LINE, std::initializer_list<int>{2, 3}, -c.vector(d).vector(c).normalize());
+        sides.emplace_back(Element::Type::LINE, std::initializer_list<int>{3, 0}, -d.vector(a).vector(d).normalize());
     }
 };
 
@@ -2,40 +2,24 @@
 #define RGS_TRIANGLE_H
 
 #include "Element.h"
-#include "Line.h"
-
-#include <iostream>
-
-class Triangle : public Element {
-    friend class boost::serialization::access;
 
+class Triangle {
 public:
-    Triangle() = default;
-
-    Triangle(int id, int physicalEntityId, int geomUnitId, const std::vector<int>& partitions, const std::vector<int>& nodeIds)
-    : Element(Type::TRIANGLE, id, physicalEntityId, geomUnitId, partitions, nodeIds) {}
-
-    explicit Triangle(const std::vector<int>& nodeIds) : Triangle(0, -1, -1, {}, nodeIds) {}
-
-private:
-    template<class Archive>
-    void serialize(Archive & ar, const unsigned int version) {
-        ar & boost::serialization::base_object<Element>(*this);
+    static double getVolume(const std::vector<Vector3d>& positions) {
+        Vector3d a = positions[1] - positions[0];
+        Vector3d b = positions[2] - positions[1];
+        return a.vector(b).module() / 2;
     }
 
-    void innerInit(const std::vector<Node*>& nodes, bool isSideElementsRequired) override {
-        Vector3d a = nodes[1]->getPosition() - nodes[0]->getPosition();
-        Vector3d b = nodes[2]->getPosition() - nodes[1]->getPosition();
-        Vector3d c = nodes[0]->getPosition() - nodes[2]->getPosition();
-
-        if (isSideElementsRequired) {
-            _sideElements.clear();
-            _sideElements.emplace_back(new SideElement(new Line({nodes[0]->getId(), nodes[1]->getId()}), -a.vector(b).vector(a).normalize()));
-            _sideElements.emplace_back(new SideElement(new Line({nodes[1]->getId(), nodes[2]->getId()}), -b.vector(c).vector(b).normalize()));
-            _sideElements.emplace_back(new SideElement(new Line({nodes[2]->getId(), nodes[0]->getId()}), -c.vector(a).vector(c).normalize()));
-        }
+    static void getSides(const std::vector<Vector3d>& positions, std::vector<Element::Side>& sides) {
+        Vector3d a = positions[1] - positions[0];
+        Vector3d b = positions[2] - positions[1];
+        Vector3d c = positions[0] - positions[2];
 
-        _volume = a.vector(b).module() / 2;
+        sides.clear();
+        sides.emplace_back(Element::Type::LINE, std::initializer_list<int>{0, 1}, -a.vector(b).vector(a).normalize());
+        sides.emplace_back(Element::Type::LINE, std::initializer_list<int>{1, 2}, -b.vector(c).vector(b).normalize());
+        sides.emplace_back(Element::Type::LINE, std::initializer_list<int>{2, 0}, -c.vector(a).vector(c).normalize());
     }
 };
 
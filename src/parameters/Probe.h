@@ -0,0 +1,66 @@
+#ifndef RGS_PROBE_H
+#define RGS_PROBE_H
+
+#include "utilities/Utils.h"
+
+#include <string>
+#include <vector>
+#include <ostream>
+
+#include <boost/serialization/access.hpp>
+#include <boost/serialization/string.hpp>
+#include <boost/serialization/vector.hpp>
+
+// set of cells (given by ids or by points in mesh units) whose macroparameters are written every few iterations
+class Probe {
+    friend class boost::serialization::access;
+
+private:
+    std::string _name;
+    std::vector<int> _elementIds;
+    std::vector<Vector3d> _points;
+
+public:
+    Probe() = default;
+
+    Probe(std::string name, std::vector<int> elementIds, std::vector<Vector3d> points)
+    : _name(std::move(name)), _elementIds(std::move(elementIds)), _points(std::move(points)) {}
+
+    const std::string& getName() const {
+        return _name;
+    }
+
+    const std::vector<int>& getElementIds() const {
+        return _elementIds;
+    }
+
+    const std::vector<Vector3d>& getPoints() const {
+        return _points;
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const Probe& probe) {
+        os << "{"
+           << "Name = " << probe._name;
+        if (probe._elementIds.empty() == false) {
+            os << "; ";
+            os << "Elements = " << Utils::toString(probe._elementIds);
+        }
+        if (probe._points.empty() == false) {
+            os << "; ";
+            os << "Points = " << probe._points.size();
+        }
+        os << "}";
+        return os;
+    }
+
+private:
+    template<class Archive>
+    void serialize(Archive & ar, const unsigned int version) {
+        ar & _name;
+        ar & _elementIds;
+        ar & _points;
+    }
+
+};
+
+#endif //RGS_PROBE_H
@@ -2,12 +2,77 @@
 
 #include <mpi.h>
 #include <cstring>
+#include <climits>
+#include <cstdint>
+#include <stdexcept>
 
 bool Parallel::_isUsingMPI = false;
 bool Parallel::_isSingle = true;
 int Parallel::_size = 1;
 int Parallel::_rank = 0;
 std::string Parallel::_name{};
+std::vector<int> Parallel::_nodeRanks{};
+
+// processes of one node and the shared memory window between them
+static MPI_Comm nodeComm = MPI_COMM_NULL;
+static MPI_Win sharedWindow = MPI_WIN_NULL;
+
+static MPI_Op toMPIOperation(Parallel::Operation operation) {
+    switch (operation) {
+        case Parallel::Operation::MIN:
+            return MPI_MIN;
+        case Parallel::Operation::MAX:
+            return MPI_MAX;
+        case Parallel::Operation::SUM:
+            return MPI_SUM;
+    }
+    return MPI_OP_NULL;
+}
+
+// buffer sizes are exchanged as size_t, mpi counts are int
+static MPI_Datatype sizeType() {
+    return sizeof(std::size_t) == sizeof(std::uint64_t) ? MPI_UINT64_T : MPI_UINT32_T;
+}
+
+static bool isCount(std::size_t value) {
+    return value <= static_cast<std::size_t>(INT_MAX);
+}
+
+static std::vector<int> toCounts(const std::vector<std::size_t>& values) {
+    return std::vector<int>(values.begin(), values.end());
+}
+
+static std::vector<std::size_t> toDisplacements(const std::vector<std::size_t>& sizes) {
+    std::vector<std::size_t> displacements(sizes.size(), 0);
+    for (std::size_t i = 1; i < sizes.size(); i++) {
+        displacements[i] = displacements[i - 1] + sizes[i - 1];
+    }
+    return displacements;
+}
+
+static bool isCounts(const std::vector<std::size_t>& sizes, const std::vector<std::size_t>& displacements) {
+    for (std::size_t i = 0; i < sizes.size(); i++) {
+        if (isCount(sizes[i]) == false || isCount(displacements[i]) == false) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// all processes throw together, otherwise the others would wait forever in the transfer
+static void checkCounts(bool isValid, const std::string& operation) {
+    if (Parallel::allreduce(isValid == true ? 0 : 1, Parallel::Operation::MAX) != 0) {
+        throw std::runtime_error(operation + ": transfer exceeds " + std::to_string(INT_MAX) + " bytes");
+    }
+}
+
+static std::vector<std::string> split(const std::vector<char>& rawBuffer, const std::vector<std::size_t>& sizes, const std::vector<std::size_t>& displacements) {
+    std::vector<std::string> buffers;
+    for (std::size_t i = 0; i < sizes.size(); i++) {
+        buffers.emplace_back(rawBuffer.data() + displacements[i], sizes[i]);
+    }
+    return buffers;
+}
 
 void Parallel::init(int *argc, char ***argv) {
     MPI_Init(argc, argv);
@@ -22,15 +87,39 @@ void Parallel::init(int *argc, char ***argv) {
     _name = std::string(processor_name, static_cast<unsigned long>(name_len));
 
     _isSingle = _size == 1;
+
+    // map world ranks to node ranks, -1 for processes on other nodes
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, _rank, MPI_INFO_NULL, &nodeComm);
+    MPI_Group worldGroup, nodeGroup;
+    MPI_Comm_group(MPI_COMM_WORLD, &worldGroup);
+    MPI_Comm_group(nodeComm, &nodeGroup);
+    std::vector<int> worldRanks(static_cast<std::size_t>(_size));
+    for (int rank = 0; rank < _size; rank++) {
+        worldRanks[rank] = rank;
+    }
+    _nodeRanks.resize(static_cast<std::size_t>(_size));
+    MPI_Group_translate_ranks(worldGroup, _size, worldRanks.data(), nodeGroup, _nodeRanks.data());
+    for (auto& nodeRank : _nodeRanks) {
+        if (nodeRank == MPI_UNDEFINED) {
+            nodeRank = -1;
+        }
+    }
+    MPI_Group_free(&worldGroup);
+    MPI_Group_free(&nodeGroup);
 }
 
 void Parallel::finalize() {
+    freeShared();
+    MPI_Comm_free(&nodeComm);
     _isUsingMPI = false;
     _isSingle = true;
     MPI_Finalize();
 }
 
 void Parallel::send(const std::string& buffer, int dest, int tag) {
+    if (isCount(buffer.size()) == false) {
+        throw std::runtime_error("send: transfer exceeds " + std::to_string(INT_MAX) + " bytes");
+    }
     MPI_Send(buffer.c_str(), static_cast<int>(buffer.size()), MPI_BYTE, dest, tag, MPI_COMM_WORLD);
 }
 
@@ -52,6 +141,167 @@ std::string Parallel::recv(int source, int tag) {
     return buffer;
 }
 
+void Parallel::broadcast(std::string& buffer, int root) {
+    std::size_t size = buffer.size();
+    MPI_Bcast(&size, 1, sizeType(), root, MPI_COMM_WORLD);
+    if (isCount(size) == false) {
+        throw std::runtime_error("broadcast: transfer exceeds " + std::to_string(INT_MAX) + " bytes");
+    }
+
+    std::vector<char> rawBuffer(buffer.begin(), buffer.end());
+    rawBuffer.resize(size);
+    MPI_Bcast(rawBuffer.data(), static_cast<int>(size), MPI_BYTE, root, MPI_COMM_WORLD);
+
+    buffer.assign(rawBuffer.begin(), rawBuffer.end());
+}
+
+double Parallel::allreduce(double value, Operation operation) {
+    double result;
+    MPI_Allreduce(&value, &result, 1, MPI_DOUBLE, toMPIOperation(operation), MPI_COMM_WORLD);
+    return result;
+}
+
+int Parallel::allreduce(int value, Operation operation) {
+    int result;
+    MPI_Allreduce(&value, &result, 1, MPI_INT, toMPIOperation(operation), MPI_COMM_WORLD);
+    return result;
+}
+
+void Parallel::allreduce(std::vector<double>& values, Operation operation) {
+    MPI_Allreduce(MPI_IN_PLACE, values.data(), static_cast<int>(values.size()), MPI_DOUBLE, toMPIOperation(operation), MPI_COMM_WORLD);
+}
+
+std::vector<double> Parallel::allgather(double value) {
+    std::vector<double> values(static_cast<std::size_t>(_size));
+    MPI_Allgather(&value, 1, MPI_DOUBLE, values.data(), 1, MPI_DOUBLE, MPI_COMM_WORLD);
+    return values;
+}
+
+std::vector<std::string> Parallel::allgather(const std::string& buffer) {
+    std::size_t size = buffer.size();
+    std::vector<std::size_t> sizes(static_cast<std::size_t>(_size));
+    MPI_Allgather(&size, 1, sizeType(), sizes.data(), 1, sizeType(), MPI_COMM_WORLD);
+
+    std::vector<std::size_t> displacements = toDisplacements(sizes);
+    if (isCounts(sizes, displacements) == false) {
+        throw std::runtime_error("allgather: transfer exceeds " + std::to_string(INT_MAX) + " bytes");
+    }
+    std::vector<char> rawBuffer(displacements.back() + sizes.back());
+    MPI_Allgatherv(buffer.data(), static_cast<int>(size), MPI_BYTE,
+                   rawBuffer.data(), toCounts(sizes).data(), toCounts(displacements).data(), MPI_BYTE, MPI_COMM_WORLD);
+
+    return split(rawBuffer, sizes, displacements);
+}
+
+std::vector<std::string> Parallel::gather(const std::string& buffer, int root) {
+    std::size_t size = buffer.size();
+    std::vector<std::size_t> sizes(static_cast<std::size_t>(_size));
+    MPI_Gather(&size, 1, sizeType(), sizes.data(), 1, sizeType(), root, MPI_COMM_WORLD);
+
+    std::vector<std::size_t> displacements = toDisplacements(sizes);
+    checkCounts(isCounts(sizes, displacements), "gather");
+    std::vector<char> rawBuffer;
+    if (_rank == root) {
+        rawBuffer.resize(displacements.back() + sizes.back());
+    }
+    MPI_Gatherv(buffer.data(), static_cast<int>(size), MPI_BYTE,
+                rawBuffer.data(), toCounts(sizes).data(), toCounts(displacements).data(), MPI_BYTE, root, MPI_COMM_WORLD);
+
+    if (_rank != root) {
+        return {};
+    }
+    return split(rawBuffer, sizes, displacements);
+}
+
+std::string Parallel::scatter(const std::vector<std::string>& buffers, int root) {
+    std::vector<std::size_t> sizes(static_cast<std::size_t>(_size));
+    if (_rank == root) {
+        for (std::size_t i = 0; i < buffers.size(); i++) {
+            sizes[i] = buffers[i].size();
+        }
+    }
+    std::vector<std::size_t> displacements = toDisplacements(sizes);
+    checkCounts(isCounts(sizes, displacements), "scatter");
+
+    std::vector<char> rawBuffer;
+    if (_rank == root) {
+        for (const auto& buffer : buffers) {
+            rawBuffer.insert(rawBuffer.end(), buffer.begin(), buffer.end());
+        }
+    }
+
+    std::size_t size;
+    MPI_Scatter(sizes.data(), 1, sizeType(), &size, 1, sizeType(), root, MPI_COMM_WORLD);
+
+    std::vector<char> rawResult(size);
+    MPI_Scatterv(rawBuffer.data(), toCounts(sizes).data(), toCounts(displacements).data(), MPI_BYTE,
+                 rawResult.data(), static_cast<int>(size), MPI_BYTE, root, MPI_COMM_WORLD);
+
+    return std::string{rawResult.begin(), rawResult.end()};
+}
+
+std::vector<std::string> Parallel::alltoall(const std::vector<std::string>& buffers) {
+    std::vector<std::size_t> sendSizes(static_cast<std::size_t>(_size));
+    for (std::size_t i = 0; i < buffers.size(); i++) {
+        sendSizes[i] = buffers[i].size();
+    }
+    std::vector<std::size_t> sendDisplacements = toDisplacements(sendSizes);
+
+    std::vector<std::size_t> recvSizes(static_cast<std::size_t>(_size));
+    MPI_Alltoall(sendSizes.data(), 1, sizeType(), recvSizes.data(), 1, sizeType(), MPI_COMM_WORLD);
+    std::vector<std::size_t> recvDisplacements = toDisplacements(recvSizes);
+    checkCounts(isCounts(sendSizes, sendDisplacements) == true && isCounts(recvSizes, recvDisplacements) == true, "alltoall");
+
+    std::vector<char> rawBuffer;
+    for (const auto& buffer : buffers) {
+        rawBuffer.insert(rawBuffer.end(), buffer.begin(), buffer.end());
+    }
+
+    std::vector<char> rawResult(recvDisplacements.back() + recvSizes.back());
+    MPI_Alltoallv(rawBuffer.data(), toCounts(sendSizes).data(), toCounts(sendDisplacements).data(), MPI_BYTE,
+                  rawResult.data(), toCounts(recvSizes).data(), toCounts(recvDisplacements).data(), MPI_BYTE, MPI_COMM_WORLD);
+
+    return split(rawResult, recvSizes, recvDisplacements);
+}
+
+double* Parallel::allocateShared(std::size_t size) {
+    freeShared();
+
+    // each process places its segment close to itself
+    MPI_Info info;
+    MPI_Info_create(&info);
+    MPI_Info_set(info, "alloc_shared_noncontig", "true");
+
+    double* memory = nullptr;
+    MPI_Win_allocate_shared(static_cast<MPI_Aint>(size * sizeof(double)), sizeof(double), info, nodeComm, &memory, &sharedWindow);
+    MPI_Info_free(&info);
+
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, sharedWindow);
+    return memory;
+}
+
+const double* Parallel::getShared(int rank) {
+    MPI_Aint size;
+    int dispUnit;
+    double* memory = nullptr;
+    MPI_Win_shared_query(sharedWindow, _nodeRanks[rank], &size, &dispUnit, &memory);
+    return memory;
+}
+
+void Parallel::syncShared() {
+    // make local writes visible, wait for the node, then see writes of others
+    MPI_Win_sync(sharedWindow);
+    MPI_Barrier(nodeComm);
+    MPI_Win_sync(sharedWindow);
+}
+
+void Parallel::freeShared() {
+    if (sharedWindow != MPI_WIN_NULL) {
+        MPI_Win_unlock_all(sharedWindow);
+        MPI_Win_free(&sharedWindow);
+    }
+}
+
 void Parallel::abort() {
     MPI_Abort(MPI_COMM_WORLD, 1);
 }
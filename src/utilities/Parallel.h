@@ -2,9 +2,17 @@
 #define PARALLEL_H
 
 #include <string>
+#include <vector>
+#include <cstddef>
 
 class Parallel {
 public:
+    enum class Operation {
+        MIN,
+        MAX,
+        SUM
+    };
+
     static const int COMMAND_MESH             = 100;
     static const int COMMAND_TIMESTEP         = 110;
     static const int COMMAND_CONFIG           = 120;
@@ -20,6 +28,7 @@ private:
     static int _size;
     static int _rank;
     static std::string _name;
+    static std::vector<int> _nodeRanks;
 
 public:
     static void init(int *argc, char ***argv);
@@ -30,6 +39,32 @@ public:
 
     static std::string recv(int source, int tag);
 
+    static void broadcast(std::string& buffer, int root);
+
+    static double allreduce(double value, Operation operation);
+
+    static int allreduce(int value, Operation operation);
+
+    static void allreduce(std::vector<double>& values, Operation operation);
+
+    static std::vector<double> allgather(double value);
+
+    static std::vector<std::string> allgather(const std::string& buffer);
+
+    static std::vector<std::string> gather(const std::string& buffer, int root);
+
+    static std::string scatter(const std::vector<std::string>& buffers, int root);
+
+    static std::vector<std::string> alltoall(const std::vector<std::string>& buffers);
+
+    static double* allocateShared(std::size_t size);
+
+    static const double* getShared(int rank);
+
+    static void syncShared();
+
+    static void freeShared();
+
     static void abort();
 
     static void barrier();
@@ -62,6 +97,10 @@ public:
         return _name;
     }
 
+    static bool isSameNode(int rank) {
+        return _nodeRanks[rank] != -1;
+    }
+
 };
 
 #endif // PARALLEL_H
\ No newline at end of file
@@ -0,0 +1,169 @@
+#include "PrecisionUtils.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+PrecisionUtils::Precision PrecisionUtils::fromString(const std::string& name) {
+    if (name == "double") {
+        return Precision::DOUBLE;
+    } else if (name == "float") {
+        return Precision::FLOAT;
+    } else if (name == "half") {
+        return Precision::HALF;
+    } else {
+        throw std::runtime_error("unknown precision: " + name);
+    }
+}
+
+std::string PrecisionUtils::toString(Precision precision) {
+    switch (precision) {
+        case Precision::DOUBLE:
+            return "double";
+        case Precision::FLOAT:
+            return "float";
+        case Precision::HALF:
+            return "half";
+    }
+    return "unknown";
+}
+
+void PrecisionUtils::pack(const double* values, std::size_t size, Precision precision, std::string& buffer) {
+    switch (precision) {
+        case Precision::DOUBLE: {
+            buffer.append(reinterpret_cast<const char*>(values), size * sizeof(double));
+            break;
+        }
+        case Precision::FLOAT: {
+            auto position = buffer.size();
+            buffer.resize(position + size * sizeof(float));
+            for (std::size_t i = 0; i < size; i++) {
+                auto value = static_cast<float>(values[i]);
+                std::memcpy(&buffer[position + i * sizeof(float)], &value, sizeof(float));
+            }
+            break;
+        }
+        case Precision::HALF: {
+            double maxModule = 0.0;
+            for (std::size_t i = 0; i < size; i++) {
+                maxModule = std::max(maxModule, std::abs(values[i]));
+            }
+            auto scale = static_cast<float>(maxModule);
+            double factor = maxModule > 0.0 ? 1.0 / maxModule : 0.0;
+
+            auto position = buffer.size();
+            buffer.resize(position + sizeof(float) + size * sizeof(std::uint16_t));
+            std::memcpy(&buffer[position], &scale, sizeof(float));
+            position += sizeof(float);
+            for (std::size_t i = 0; i < size; i++) {
+                auto half = toHalf(static_cast<float>(values[i] * factor));
+                std::memcpy(&buffer[position + i * sizeof(std::uint16_t)], &half, sizeof(std::uint16_t));
+            }
+            break;
+        }
+    }
+}
+
+const char* PrecisionUtils::unpack(const char* buffer, Precision precision, double* values, std::size_t size) {
+    switch (precision) {
+        case Precision::DOUBLE: {
+            std::memcpy(values, buffer, size * sizeof(double));
+            return buffer + size * sizeof(double);
+        }
+        case Precision::FLOAT: {
+            for (std::size_t i = 0; i < size; i++) {
+                float value;
+                std::memcpy(&value, buffer + i * sizeof(float), sizeof(float));
+                values[i] = value;
+            }
+            return buffer + size * sizeof(float);
+        }
+        case Precision::HALF: {
+            float scale;
+            std::memcpy(&scale, buffer, sizeof(float));
+            buffer += sizeof(float);
+            for (std::size_t i = 0; i < size; i++) {
+                std::uint16_t half;
+                std::memcpy(&half, buffer + i * sizeof(std::uint16_t), sizeof(std::uint16_t));
+                values[i] = static_cast<double>(fromHalf(half)) * scale;
+            }
+            return buffer + size * sizeof(std::uint16_t);
+        }
+    }
+    return buffer;
+}
+
+std::uint16_t PrecisionUtils::toHalf(float value) {
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(float));
+
+    std::uint32_t sign = (bits >> 16) & 0x8000u;
+    std::uint32_t exponent = (bits >> 23) & 0xffu;
+    std::uint32_t mantissa = bits & 0x7fffffu;
+
+    // infinity and nan
+    if (exponent == 0xffu) {
+        return static_cast<std::uint16_t>(sign | 0x7c00u | (mantissa != 0 ? 0x200u : 0u));
+    }
+
+    int halfExponent = static_cast<int>(exponent) - 127 + 15;
+
+    // overflow
+    if (halfExponent >= 0x1f) {
+        return static_cast<std::uint16_t>(sign | 0x7c00u);
+    }
+
+    // subnormal or zero, round to nearest even
+    if (halfExponent <= 0) {
+        if (halfExponent < -10) {
+            return static_cast<std::uint16_t>(sign);
+        }
+        mantissa |= 0x800000u;
+        auto shift = static_cast<std::uint32_t>(14 - halfExponent);
+        std::uint32_t halfMantissa = mantissa >> shift;
+        std::uint32_t remainder = mantissa & ((1u << shift) - 1);
+        std::uint32_t halfway = 1u << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (halfMantissa & 1u) != 0)) {
+            halfMantissa++;
+        }
+        return static_cast<std::uint16_t>(sign | halfMantissa);
+    }
+
+    // normal, round to nearest even (carry can move value to the next exponent)
+    std::uint32_t half = sign | (static_cast<std::uint32_t>(halfExponent) << 10) | (mantissa >> 13);
+    std::uint32_t remainder = mantissa & 0x1fffu;
+    if (remainder > 0x1000u || (remainder == 0x1000u && (half & 1u) != 0)) {
+        half++;
+    }
+    return static_cast<std::uint16_t>(half);
+}
+
+float PrecisionUtils::fromHalf(std::uint16_t half) {
+    std::uint32_t sign = static_cast<std::uint32_t>(half & 0x8000u) << 16;
+    std::uint32_t exponent = (half >> 10) & 0x1fu;
+    std::uint32_t mantissa = half & 0x3ffu;
+
+    std::uint32_t bits;
+    if (exponent == 0x1fu) {
+        bits = sign | 0x7f800000u | (mantissa << 13);
+    } else if (exponent != 0) {
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    } else if (mantissa == 0) {
+        bits = sign;
+    } else {
+
+        // subnormal, normalize it
+        exponent = 113;
+        while ((mantissa & 0x400u) == 0) {
+            mantissa <<= 1;
+            exponent--;
+        }
+        mantissa &= 0x3ffu;
+        bits = sign | (exponent << 23) | (mantissa << 13);
+    }
+
+    float value;
+    std::memcpy(&value, &bits, sizeof(float));
+    return value;
+}
@@ -0,0 +1,32 @@
+#ifndef RGS_PRECISIONUTILS_H
+#define RGS_PRECISIONUTILS_H
+
+#include <string>
+#include <cstdint>
+
+class PrecisionUtils {
+public:
+    enum class Precision {
+        DOUBLE,
+        FLOAT,
+        HALF
+    };
+
+    static Precision fromString(const std::string& name);
+
+    static std::string toString(Precision precision);
+
+    // appends block of values to buffer, half precision block is scaled by its maximum module
+    static void pack(const double* values, std::size_t size, Precision precision, std::string& buffer);
+
+    // reads block of values from buffer, returns position after block
+    static const char* unpack(const char* buffer, Precision precision, double* values, std::size_t size);
+
+    static std::uint16_t toHalf(float value);
+
+    static float fromHalf(std::uint16_t half);
+
+};
+
+
+#endif //RGS_PRECISIONUTILS_H
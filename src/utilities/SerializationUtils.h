@@ -15,7 +15,6 @@ public:
     static std::string serialize(T object) {
         std::ostringstream os;
         boost::archive::binary_oarchive oa(os);
-        setUpOutArchive(oa);
         oa << object;
         return os.str();
     }
@@ -24,14 +23,9 @@ public:
     static void deserialize(const std::string& buffer, T& object) {
         std::istringstream is(buffer);
         boost::archive::binary_iarchive ia(is);
-        setUpInArchive(ia);
         ia >> object;
     }
 
-private:
-    static void setUpOutArchive(boost::archive::binary_oarchive& oa);
-    static void setUpInArchive(boost::archive::binary_iarchive& ia);
-
 };
 
 
@@ -4,6 +4,8 @@
 #include <sstream>
 #include <vector>
 #include <chrono>
+#include <thread>
+#include <exception>
 
 const double BOLTZMANN_CONSTANT = 1.38e-23; // Boltzmann const // TODO: Make more precise
 
@@ -49,6 +51,34 @@ public:
         return basicValues;
     }
 
+    // runs function for each chunk, first chunk is done by calling thread
+    template<class Function>
+    static void forEachChunk(std::size_t chunksSize, Function function) {
+        std::vector<std::exception_ptr> exceptions(chunksSize);
+        auto safeFunction = [&function, &exceptions](std::size_t ci) {
+            try {
+                function(ci);
+            } catch (...) {
+                exceptions[ci] = std::current_exception();
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (std::size_t ci = 1; ci < chunksSize; ci++) {
+            threads.emplace_back(safeFunction, ci);
+        }
+        safeFunction(0);
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        for (const auto& exception : exceptions) {
+            if (exception != nullptr) {
+                std::rethrow_exception(exception);
+            }
+        }
+    }
+
     static std::string getCurrentDateAndTime() {
         auto now = std::chrono::system_clock::now();
         auto now_time_t = std::chrono::system_clock::to_time_t(now);